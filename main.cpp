@@ -1,19 +1,472 @@
 #include"parallel_hash_map.h"
 #include<time.h>
 #include<string>
+#ifdef STDTHREAD
+#include<thread>
+#include<chrono>
+#endif
 
 struct hamm{
     int x1;
     int x2;
 };
 
-int main()
+#ifdef BENCHMARK
+// wall clock time in seconds
+double get_time()
 {
+    #ifdef OPENMP
+    return omp_get_wtime();
+    #elif defined(STDTHREAD)
+    return std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    #else
+    return (double) clock() / CLOCKS_PER_SEC;
+    #endif
+}
+
+// lookup throughput into a table large enough to defeat the DTLB
+void large_table_benchmark()
+{
+    long M = 0x01 << 24;
+    long n = M / 2;
+    long num_lookups = 0x01 << 24;
+    long a = 1664525;
+    long c = 1013904223;
+    long m = 0x01L << 32;
+
+    fixed_hash_map<long,long> table(M);
+    long *key_list = new long[n];
+    long num = 1;
+    for(long i=0; i<n; i++)
+    {
+        num = (a*num + c) % m;
+        key_list[i] = num;
+        table.insert(num, i);
+    }
+
+    // alternate between random present and random absent keys
+    double t1 = get_time();
+    long hits = 0;
+    num = 7;
+    for(long i=0; i<num_lookups; i++)
+    {
+        num = (a*num + c) % m;
+        long key = (i % 2 == 0) ? key_list[num % n] : num;
+        hits += (long) table.contains(key);
+    }
+    double t2 = get_time();
+    delete[] key_list;
+
+    std::cout << "Large table (" << M << " buckets, " << table.size()
+        << " keys): " << num_lookups / (t2 - t1) / 1e6
+        << " M lookups/s, " << hits << " hits" << std::endl;
+}
+
+// scrambles an integer so that consecutive keys land in random buckets
+long scramble(long x)
+{
+    unsigned long h = (unsigned long) x;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdUL;
+    h ^= h >> 33;
+    return (long) h;
+}
+
+// lookup throughput with and without a Bloom filter across hit ratios
+void filter_benchmark()
+{
+    long n = 0x01 << 21;
+    long num_lookups = 0x01 << 23;
+    long a = 1664525;
+    long c = 1013904223;
+    long m = 0x01L << 32;
+    size_t filter_bits[3] = {0, 8, 16};
+    double hit_ratios[5] = {0.0, 0.1, 0.5, 0.9, 1.0};
+
+    for(int f=0; f<3; f++)
+    {
+        // keys scrambled from [0,n) are present, from [n,2n) absent
+        parallel_hash_map<long,long> table(64, 64, filter_bits[f]);
+        for(long i=0; i<n; i++)
+            table.insert(scramble(i), i);
+
+        std::cout << "Filter with " << filter_bits[f] << " bits/key ("
+            << table.filter_bytes() << " bytes):";
+        for(int r=0; r<5; r++)
+        {
+            long threshold = (long) (hit_ratios[r] * m);
+            double t1 = get_time();
+            long hits = 0;
+            #pragma omp parallel for reduction(+:hits) schedule(static)
+            for(long i=0; i<num_lookups; i++)
+            {
+                long num = (a*i + c) % m;
+                long key = num % n;
+                if(((a*num + c) % m) >= threshold)
+                    key += n;
+                hits += (long) table.contains(scramble(key));
+            }
+            double t2 = get_time();
+            std::cout << " " << hit_ratios[r] << " hits: "
+                << num_lookups / (t2 - t1) / 1e6 << " M/s";
+        }
+        std::cout << std::endl;
+    }
+}
+
+// the insert/lookup pattern of main on a map holding only a few hundred keys
+template <class Map>
+double tiny_map_workload(Map &X)
+{
+    long a = 1664525;
+    long c = 1013904223;
+    long m = 0x01L << 31;
+    long len = 0x01 << 22;
+    long prime = 194;
+
+    double t1 = get_time();
+    #pragma omp parallel default(none) shared(X, m, prime, a, c, len)
+    {
+        long num = prime;
+        #ifdef OPENMP
+        num = prime / (omp_get_thread_num() + 1) + 1;
+        #endif
+        #pragma omp for
+        for(long i=0; i<len; i++)
+        {
+            num = (a*num + c) % m;
+            X.insert_and_get_count(num % prime, i);
+        }
+    }
+
+    long sum = 0;
+    #pragma omp parallel for default(none) shared(X, len) reduction(+:sum)
+    for(long i=0; i<5*len; i++)
+        sum += (long) X.contains(i);
+    double t2 = get_time();
+
+    return t2 - t1;
+}
+
+// compares the general parallel map against the small map on tiny key sets
+void small_map_benchmark()
+{
+    parallel_hash_map<long,long> general;
+    double t_general = tiny_map_workload(general);
+    static small_parallel_hash_map<long,long,256> small;
+    double t_small = tiny_map_workload(small);
+    std::cout << "Tiny key set (" << small.size() << " keys): parallel map "
+        << t_general << " s, small map " << t_small << " s" << std::endl;
+}
+
+// interning a stream of repeated keys into dense identifiers
+void interner_benchmark()
+{
+    long n = 0x01 << 22;
+    long num_distinct = 0x01 << 18;
+    long *keys = new long[n];
+    int *ids = new int[n];
+    for(long i=0; i<n; i++)
+        keys[i] = scramble((i * 2654435761L) % num_distinct);
+
+    // the pattern of main: a heap value allocated for every attempt
+    parallel_hash_map<long,hamm*> X;
+    double t1 = get_time();
+    #pragma omp parallel for default(none) shared(X, keys, ids, n)
+    for(long i=0; i<n; i++)
+    {
+        hamm *h = new hamm;
+        ids[i] = X.insert_and_get_count(keys[i], h);
+        if(ids[i] == -1)
+            delete h;
+    }
+    double t2 = get_time();
+
+    // dense identifiers for every key, including repeated ones
+    concurrent_interner<long> interner;
+    double t3 = get_time();
+    interner.intern_many(keys, n, ids);
+    double t4 = get_time();
+
+    long errors = 0;
+    for(long i=0; i<n; i++)
+        if(interner.key(ids[i]) != keys[i])
+            errors++;
+
+    std::cout << "Interning " << n << " keys (" << interner.size()
+        << " distinct): insert_and_get_count " << t2 - t1 << " s, interner "
+        << t4 - t3 << " s, " << errors << " errors" << std::endl;
+
+    hamm **value_list = X.values();
+    for(size_t i=0; i<X.size(); i++)
+        delete value_list[i];
+    delete[] value_list;
+    delete[] keys;
+    delete[] ids;
+}
+
+// bulk construction from arrays against inserting pairs one at a time
+void build_benchmark()
+{
+    long n = 0x01 << 22;
+    long *keys = new long[n];
+    long *values = new long[n];
+    int *counts = new int[n];
+    for(long i=0; i<n; i++)
+    {
+        keys[i] = scramble(i % (n / 2));
+        values[i] = i;
+    }
+
+    parallel_hash_map<long,long> X;
+    double t1 = get_time();
+    #pragma omp parallel for default(none) shared(X, keys, values, n)
+    for(long i=0; i<n; i++)
+        X.insert(keys[i], values[i]);
+    double t2 = get_time();
+
+    double t3 = get_time();
+    parallel_hash_map<long,long> *Y =
+        parallel_hash_map<long,long>::build(keys, values, n, counts);
+    double t4 = get_time();
+
+    std::cout << "Building from " << n << " pairs (" << Y->size()
+        << " distinct): insert " << t2 - t1 << " s, build " << t4 - t3
+        << " s" << std::endl;
+
+    delete Y;
+    delete[] keys;
+    delete[] values;
+    delete[] counts;
+}
+
+// clearing and refilling the map every timestep, then shrinking it
+void clear_benchmark()
+{
+    long n = 0x01 << 21;
+    int num_steps = 8;
+    parallel_hash_map<long,long> X;
+
+    double t_clear = 0;
+    double t_fill = 0;
+    for(int s=0; s<num_steps; s++)
+    {
+        double t1 = get_time();
+        X.clear();
+        double t2 = get_time();
+        #pragma omp parallel for default(none) shared(X, n, s)
+        for(long i=0; i<n; i++)
+            X.insert(scramble(i + s), i);
+        double t3 = get_time();
+        t_clear += t2 - t1;
+        t_fill += t3 - t2;
+    }
+
+    size_t peak_buckets = X.bucket_count();
+    X.clear();
+    X.shrink_to_fit();
+
+    std::cout << "Clear and refill " << n << " keys: clear "
+        << t_clear / num_steps << " s, refill " << t_fill / num_steps
+        << " s per step; " << peak_buckets << " buckets shrunk to "
+        << X.bucket_count() << std::endl;
+}
+
+// time to probe every key of a map or set and the bytes it uses per entry
+template <class Map>
+void report_memory(const char *name, Map &X, long n)
+{
+    double t1 = get_time();
+    long hits = 0;
+    #pragma omp parallel for default(none) shared(X, n) reduction(+:hits)
+    for(long i=0; i<2*n; i++)
+        hits += (long) X.contains(scramble(i));
+    double t2 = get_time();
+
+    std::cout << "  " << name << ": " << (double) X.memory_usage() / X.size()
+        << " bytes/entry, " << 2*n / (t2 - t1) / 1e6 << " M lookups/s, "
+        << hits << " hits" << std::endl;
+}
+
+// memory per entry of the storage layouts for 8-byte keys and values
+void memory_benchmark()
+{
+    long n = 3 * (0x01 << 19);
+    parallel_hash_map<long,long> inline_map;
+    parallel_hash_map<long,long,spin_lock,split_storage> split_map;
+    parallel_hash_set<long> set;
+    #pragma omp parallel for default(none) \
+        shared(inline_map, split_map, set, n)
+    for(long i=0; i<n; i++)
+    {
+        inline_map.insert(scramble(i), i);
+        split_map.insert(scramble(i), i);
+        set.insert(scramble(i));
+    }
+
+    std::cout << "Memory for " << n << " entries:" << std::endl;
+    report_memory("inline map", inline_map, n);
+    report_memory("split map", split_map, n);
+    report_memory("set", set, n);
+}
+
+// combining privately built tables: copy and insert against merge_from
+void merge_benchmark()
+{
+    long n = 0x01 << 22;
+    long num_distinct = 0x01 << 20;
+    int num_parts = 8;
+
+    // each part is built without synchronization, as a thread would
+    fixed_hash_map<long,long> *parts[2][8];
+    for(int c=0; c<2; c++)
+    {
+        #pragma omp parallel for default(none) shared(parts, n, num_parts, \
+            num_distinct, c)
+        for(int p=0; p<num_parts; p++)
+        {
+            parts[c][p] = new fixed_hash_map<long,long>(2 * n / num_parts);
+            for(long i=p; i<n; i+=num_parts)
+                parts[c][p]->insert(scramble(i % num_distinct), i);
+        }
+    }
+
+    // combine with keys(), values() and an insert per key
+    parallel_hash_map<long,long> X;
+    double t1 = get_time();
+    for(int p=0; p<num_parts; p++)
+    {
+        long *key_list = parts[0][p]->keys();
+        long *value_list = parts[0][p]->values();
+        long num_keys = parts[0][p]->size();
+        #pragma omp parallel for default(none) \
+            shared(X, key_list, value_list, num_keys)
+        for(long i=0; i<num_keys; i++)
+            X.insert(key_list[i], value_list[i]);
+        delete[] key_list;
+        delete[] value_list;
+    }
+    double t2 = get_time();
+
+    // combine by merging the tables
+    parallel_hash_map<long,long> Y;
+    double t3 = get_time();
+    Y.merge_from(parts[1], num_parts);
+    double t4 = get_time();
+
+    std::cout << "Combining " << num_parts << " tables (" << Y.size()
+        << " keys): insert " << t2 - t1 << " s, merge_from " << t4 - t3
+        << " s" << std::endl;
+
+    for(int c=0; c<2; c++)
+        for(int p=0; p<num_parts; p++)
+            delete parts[c][p];
+}
+#endif
+
+#ifdef MPI
+// batched inserts and lookups into a map partitioned across all ranks
+int distributed_example()
+{
+    int rank, num_ranks;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &num_ranks);
+
+    distributed_hash_map<long,long> D;
+
+    // every rank inserts an overlapping range of keys
+    long n = 0x01 << 16;
+    long *keys = new long[n];
+    long *values = new long[n];
+    long *counts = new long[n];
+    for(long i=0; i<n; i++)
+    {
+        keys[i] = (long) rank * n / 2 + i;
+        values[i] = 2 * keys[i];
+    }
+    D.insert_and_get_count(keys, values, n, counts);
+
+    // every key should be counted exactly once across all ranks
+    long num_keys = (long) (num_ranks + 1) * n / 2;
+    int *seen = new int[num_keys]();
+    for(long i=0; i<n; i++)
+        if(counts[i] >= 0 && counts[i] < num_keys)
+            seen[counts[i]]++;
+    MPI_Allreduce(MPI_IN_PLACE, seen, num_keys, MPI_INT, MPI_SUM,
+                  MPI_COMM_WORLD);
+    int errors = 0;
+    for(long i=0; i<num_keys; i++)
+        if(seen[i] != 1)
+            errors++;
+    if(D.size() != (size_t) num_keys)
+        errors++;
+
+    // look up present and absent keys
+    bool *present = new bool[n];
+    for(long i=0; i<n; i++)
+        keys[i] = (long) i * (num_ranks + 1);
+    D.contains(keys, n, present);
+    for(long i=0; i<n; i++)
+        if(present[i] != (keys[i] < num_keys))
+            errors++;
+    for(long i=0; i<n; i++)
+        keys[i] = (long) (rank + 1) * i % num_keys;
+    D.at(keys, n, values);
+    for(long i=0; i<n; i++)
+        if(values[i] != 2 * keys[i])
+            errors++;
+
+    MPI_Allreduce(MPI_IN_PLACE, &errors, 1, MPI_INT, MPI_SUM, MPI_COMM_WORLD);
+    if(rank == 0)
+        std::cout << "Distributed map on " << num_ranks << " ranks: "
+            << D.size() << " keys, " << errors << " errors" << std::endl;
+
+    delete[] keys;
+    delete[] values;
+    delete[] counts;
+    delete[] seen;
+    delete[] present;
+    return errors;
+}
+#endif
+
+int main(int argc, char* argv[])
+{
+    #ifdef MPI
+    // the local maps run OpenMP regions between MPI calls of the main thread
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    if(provided < MPI_THREAD_FUNNELED)
+    {
+        std::cout << "MPI does not support MPI_THREAD_FUNNELED" << std::endl;
+        MPI_Finalize();
+        return 1;
+    }
+    int errors = distributed_example();
+    MPI_Finalize();
+    return errors != 0;
+    #endif
+
     // set up threads
     #ifdef OPENMP
     size_t max_threads = omp_get_num_procs();
     std::cout << "Requesting " << max_threads << " threads\n";
     omp_set_num_threads(max_threads);
+    #elif defined(STDTHREAD)
+    size_t max_threads = thread_registry::max_threads();
+    std::cout << "Requesting " << max_threads << " threads\n";
+    #endif
+
+    #ifdef BENCHMARK
+    large_table_benchmark();
+    filter_benchmark();
+    small_map_benchmark();
+    interner_benchmark();
+    build_benchmark();
+    clear_benchmark();
+    memory_benchmark();
+    merge_benchmark();
     #endif
 
     // initialize hash map
@@ -23,6 +476,9 @@ int main()
     double t1, t2;
     #ifdef OPENMP
     t1 = omp_get_wtime();
+    #elif defined(STDTHREAD)
+    t1 = std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
     #else
     t1 = (double) clock() / 1e6;
     #endif
@@ -37,6 +493,27 @@ int main()
     long prime = 194;
 
     std::cout << "Starting inserts..." << std::endl;
+    #ifdef STDTHREAD
+    std::vector<std::thread> workers;
+    for(size_t t=0; t<max_threads; t++)
+        workers.push_back(std::thread([&, t]()
+        {
+            long num = prime / (t + 1) + 1;
+            long start = t * len / max_threads;
+            long end = (t + 1) * len / max_threads;
+            for(long i=start; i<end; i++)
+            {
+                // form key name
+                num = (a*num + c) % m;
+                hamm *h = new hamm;
+                int haha = X.insert_and_get_count(num%prime, h);
+                h->x1 = i;
+                h->x2 = haha;
+            }
+        }));
+    for(size_t t=0; t<max_threads; t++)
+        workers[t].join();
+    #else
     #pragma omp parallel default(none) \
     shared(X, m, prime, a, c, len) private(num)
     {
@@ -54,8 +531,24 @@ int main()
             h->x2 = haha;
         }
     }
+    #endif
 
     int sum = 0;
+    #ifdef STDTHREAD
+    std::vector<int> sums(max_threads, 0);
+    workers.clear();
+    for(size_t t=0; t<max_threads; t++)
+        workers.push_back(std::thread([&, t]()
+        {
+            for(long i=t; i<5*len; i+=max_threads)
+                sums[t] += (int) X.contains(i);
+        }));
+    for(size_t t=0; t<max_threads; t++)
+    {
+        workers[t].join();
+        sum += sums[t];
+    }
+    #else
     #pragma omp parallel for default(none) \
     shared(X, len) schedule(dynamic,100) \
     reduction(+:sum)
@@ -65,9 +558,13 @@ int main()
         int ans = (int) X.contains(key);
         sum += ans;
     }
+    #endif
 
     #ifdef OPENMP
     t2 = omp_get_wtime();
+    #elif defined(STDTHREAD)
+    t2 = std::chrono::duration<double>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
     #else
     t2 = (double) clock() / 1e6;
     #endif
@@ -13,109 +13,3045 @@
 #include<iostream>
 #include<stdexcept>
 #include<functional>
+#include<atomic>
+#include<thread>
+#include<mutex>
+#include<vector>
+#include<new>
+#include<cstdlib>
+#include<algorithm>
 #ifdef OPENMP
 #include<omp.h>
 #endif
+#ifdef HUGEPAGES
+#include<sys/mman.h>
+#endif
+#ifdef __GLIBC__
+#include<malloc.h>
+#endif
+#ifdef __linux__
+#include<sys/syscall.h>
+#include<linux/membarrier.h>
+#include<unistd.h>
+#endif
+#ifdef MPI
+// the MPI macro would clash with the deprecated MPI:: C++ bindings
+#define OMPI_SKIP_MPICXX
+#define MPICH_SKIP_MPICXX
+#include<mpi.h>
+#endif
+
+// bucket arrays at least this large (in bytes) are backed by huge pages
+#ifndef HUGE_PAGE_THRESHOLD
+#define HUGE_PAGE_THRESHOLD (2UL << 20)
+#endif
+
+// size of the pages requested when explicit hugetlbfs pages are configured
+#if defined(HUGETLB_1GB)
+#define HUGETLB_PAGE_SIZE (1UL << 30)
+#define HUGETLB_FLAGS (MAP_HUGETLB | (30 << MAP_HUGE_SHIFT))
+#elif defined(HUGETLB_2MB)
+#define HUGETLB_PAGE_SIZE (2UL << 20)
+#define HUGETLB_FLAGS (MAP_HUGETLB | (21 << MAP_HUGE_SHIFT))
+#endif
+
+// explicit huge pages are only requested for allocations at least this large,
+// so that rounding up to whole pages at most doubles the memory used
+#if defined(HUGETLB_PAGE_SIZE) && !defined(HUGETLB_THRESHOLD)
+#define HUGETLB_THRESHOLD (HUGETLB_PAGE_SIZE / 2)
+#endif
+
+/**
+ * @brief Allocates zero-initialized memory for the table of a hash map.
+ * @details Small tables are allocated from the heap. When compiled with
+ *          HUGEPAGES, tables of at least HUGE_PAGE_THRESHOLD bytes are instead
+ *          mapped directly with mmap. If explicit hugetlbfs pages are
+ *          configured (HUGETLB_2MB or HUGETLB_1GB) they are requested first
+ *          for allocations of at least HUGETLB_THRESHOLD bytes, as the
+ *          length is rounded up to whole pages. Otherwise, for smaller
+ *          allocations, or if the hugetlbfs pool is exhausted, the mapping is
+ *          aligned to a 2MB boundary and marked with MADV_HUGEPAGE so that the
+ *          kernel backs it with transparent huge pages. This removes most of
+ *          the DTLB misses incurred by lookups into very large tables.
+ * @param bytes number of bytes requested
+ * @param mapped set to the length of the mapping if the memory was obtained
+ *          with mmap, or zero if it was allocated from the heap
+ * @return pointer to the zero-initialized memory
+ */
+inline void* allocate_table_memory(size_t bytes, size_t &mapped)
+{
+    mapped = 0;
+
+    #ifdef HUGEPAGES
+    if(bytes >= HUGE_PAGE_THRESHOLD)
+    {
+        // try explicit huge pages from the hugetlbfs pool
+        #ifdef HUGETLB_PAGE_SIZE
+        if(bytes >= HUGETLB_THRESHOLD)
+        {
+            size_t length = (bytes + HUGETLB_PAGE_SIZE - 1) &
+                ~(HUGETLB_PAGE_SIZE - 1);
+            void *ptr = mmap(NULL, length, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS | HUGETLB_FLAGS, -1, 0);
+            if(ptr != MAP_FAILED)
+            {
+                mapped = length;
+                return ptr;
+            }
+        }
+        #endif
+
+        // over-allocate so that the mapping can be aligned to a huge page
+        size_t align = 2UL << 20;
+        size_t length_thp = (bytes + align - 1) & ~(align - 1);
+        char *raw = (char*) mmap(NULL, length_thp + align,
+                PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(raw != (char*) MAP_FAILED)
+        {
+            // trim the unaligned head and tail of the mapping
+            char *aligned = (char*) (((size_t) raw + align - 1) & ~(align - 1));
+            if(aligned != raw)
+                munmap(raw, aligned - raw);
+            munmap(aligned + length_thp, raw + align - aligned);
+
+            // ask the kernel for transparent huge pages
+            madvise(aligned, length_thp, MADV_HUGEPAGE);
+            mapped = length_thp;
+            return aligned;
+        }
+    }
+    #endif
+
+    // fall back to a regular heap allocation
+    void *ptr = calloc(1, bytes);
+    if(ptr == NULL)
+        throw std::bad_alloc();
+    return ptr;
+}
+
+/**
+ * @brief Frees memory allocated with <allocate_table_memory>
+ * @param ptr pointer to the memory to be freed
+ * @param mapped length of the mapping as returned by <allocate_table_memory>
+ */
+inline void free_table_memory(void *ptr, size_t mapped)
+{
+    #ifdef HUGEPAGES
+    if(mapped != 0)
+    {
+        munmap(ptr, mapped);
+        return;
+    }
+    #endif
+    free(ptr);
+}
+
+/**
+ * @class concurrent_bloom_filter ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief A blocked Bloom filter supporting concurrent insertions and queries
+ * @details The filter is an array of 64-byte blocks, each the size of a cache
+ *      line. A key selects a single block and sets several bits within it,
+ *      so that a query touches exactly one cache line. Bits are set with
+ *      atomic updates, allowing insertions from several threads concurrently
+ *      with lock-free queries. The false positive rate is set by the number
+ *      of bits reserved per key: about 1% for 10 bits per key and 0.1% for
+ *      16 bits per key at the nominal capacity.
+ */
+template <class K>
+class concurrent_bloom_filter
+{
+    private:
+        std::atomic<unsigned long long> *_blocks;   // cache-line aligned blocks
+        void *_memory;                  // start of the allocation
+        size_t _mapped;                 // length of the mapping (0 if heap)
+        size_t _num_blocks;             // number of blocks, a power of 2
+        int _num_hashes;                // number of bits set per key
+        unsigned long long hash(K key);
+
+    public:
+        concurrent_bloom_filter(size_t num_keys, size_t bits_per_key);
+        virtual ~concurrent_bloom_filter();
+        void insert(K key);
+        bool may_contain(K key);
+        void clear();
+        size_t memory_usage();
+};
+
+/**
+ * @brief Constructor allocates an empty filter sized for a number of keys
+ * @param num_keys number of keys the filter is expected to hold
+ * @param bits_per_key number of filter bits reserved per key
+ */
+template <class K>
+concurrent_bloom_filter<K>::concurrent_bloom_filter(size_t num_keys,
+        size_t bits_per_key)
+{
+    // 512 bits per block, rounded up to a power of 2 number of blocks
+    size_t num_blocks = (num_keys * bits_per_key + 511) / 512;
+    _num_blocks = 1;
+    while(_num_blocks < num_blocks)
+        _num_blocks *= 2;
+
+    // the optimal number of hashes is bits_per_key * ln(2)
+    _num_hashes = (int) (bits_per_key * 0.693 + 0.5);
+    if(_num_hashes < 1)
+        _num_hashes = 1;
+    if(_num_hashes > 16)
+        _num_hashes = 16;
+
+    // allocate blocks aligned to cache lines
+    size_t bytes = _num_blocks * 64;
+    _memory = allocate_table_memory(bytes + 64, _mapped);
+    _blocks = (std::atomic<unsigned long long>*)
+        (((size_t) _memory + 63) & ~((size_t) 63));
+}
+
+/**
+ * @brief Destructor frees the filter blocks
+ */
+template <class K>
+concurrent_bloom_filter<K>::~concurrent_bloom_filter()
+{
+    free_table_memory(_memory, _mapped);
+}
+
+/**
+ * @brief Computes a well-mixed 64-bit hash of a key
+ * @details The standard library hash of integers is the identity, so the
+ *          result is scrambled with the finalizer of MurmurHash3 before its
+ *          bits are used to select blocks and bit positions.
+ * @param key key to be hashed
+ * @return mixed hash of the key
+ */
+template <class K>
+unsigned long long concurrent_bloom_filter<K>::hash(K key)
+{
+    unsigned long long h = std::hash<K>()(key);
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+/**
+ * @brief Inserts a key into the filter
+ * @details The low bits of the hash select the block and the high bits
+ *          generate the bit positions within the block by double hashing.
+ *          Bits are set atomically so that concurrent insertions into the
+ *          same block are not lost.
+ * @param key key to be inserted
+ */
+template <class K>
+void concurrent_bloom_filter<K>::insert(K key)
+{
+    unsigned long long h = hash(key);
+    std::atomic<unsigned long long> *block =
+        &_blocks[(h & (_num_blocks - 1)) * 8];
+    unsigned int a = (unsigned int) (h >> 32);
+    unsigned int b = (unsigned int) (h >> 41) | 1;
+    for(int i=0; i<_num_hashes; i++)
+    {
+        unsigned int bit = (a + i * b) & 511;
+        unsigned long long mask = 1ULL << (bit & 63);
+        block[bit >> 6].fetch_or(mask, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Determine whether a key may have been inserted into the filter
+ * @param key key to be searched
+ * @return false if the key was definitely never inserted, true otherwise
+ */
+template <class K>
+bool concurrent_bloom_filter<K>::may_contain(K key)
+{
+    unsigned long long h = hash(key);
+    std::atomic<unsigned long long> *block =
+        &_blocks[(h & (_num_blocks - 1)) * 8];
+    unsigned int a = (unsigned int) (h >> 32);
+    unsigned int b = (unsigned int) (h >> 41) | 1;
+
+    // form the pattern of bits expected in the block
+    unsigned long long pattern[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for(int i=0; i<_num_hashes; i++)
+    {
+        unsigned int bit = (a + i * b) & 511;
+        pattern[bit >> 6] |= 1ULL << (bit & 63);
+    }
+
+    // compare the whole block at once to avoid a branch per bit
+    unsigned long long missing = 0;
+    for(int w=0; w<8; w++)
+        missing |= pattern[w] & ~block[w].load(std::memory_order_relaxed);
+    return missing == 0;
+}
+
+/**
+ * @brief Removes all keys from the filter
+ */
+template <class K>
+void concurrent_bloom_filter<K>::clear()
+{
+    for(size_t i=0; i<8*_num_blocks; i++)
+        _blocks[i].store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the number of bytes used by the filter blocks
+ * @return size of the filter in bytes
+ */
+template <class K>
+size_t concurrent_bloom_filter<K>::memory_usage()
+{
+    return _num_blocks * 64;
+}
+
+/**
+ * @brief Pauses briefly inside a spin-wait loop
+ * @details A pause instruction is issued to reduce the cost of spinning on
+ *          processors which support it. After many unsuccessful spins the
+ *          thread yields its processor, in case the thread it waits on has
+ *          been preempted.
+ * @param spins number of times the caller has already spun, incremented
+ */
+inline void cpu_relax(size_t &spins)
+{
+    #if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+    #endif
+    if(++spins % 1024 == 0)
+        std::this_thread::yield();
+}
+
+/**
+ * @brief Determine whether the kernel supports process-wide memory barriers
+ * @details On Linux, the process registers once for expedited membarrier
+ *          calls. If registration fails, or on other systems, the fences
+ *          below fall back to regular full fences.
+ * @return boolean value referring to whether membarrier can be used
+ */
+inline bool membarrier_available()
+{
+    #if defined(__linux__) && defined(__NR_membarrier)
+    static const bool available = syscall(__NR_membarrier,
+        MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+    return available;
+    #else
+    return false;
+    #endif
+}
+
+/**
+ * @brief Fence on the frequently executed side of an asymmetric handshake
+ * @details Readers announcing a table and inserters acquiring a stripe must
+ *          order their store before their following load. When membarrier
+ *          is available, only the compiler is prevented from reordering and
+ *          the rarely executed side pays for the ordering with
+ *          <heavy_fence>. Otherwise a full fence is issued.
+ */
+inline void light_fence()
+{
+    if(membarrier_available())
+        std::atomic_signal_fence(std::memory_order_seq_cst);
+    else
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+/**
+ * @brief Fence on the rarely executed side of an asymmetric handshake
+ * @details When membarrier is available, every running thread of the
+ *          process executes a full memory barrier before this function
+ *          returns, which upgrades all <light_fence> calls to full fences.
+ */
+inline void heavy_fence()
+{
+    #if defined(__linux__) && defined(__NR_membarrier)
+    if(membarrier_available())
+    {
+        syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0);
+        return;
+    }
+    #endif
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+/**
+ * @class spin_lock ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief A test-and-test-and-set spinlock
+ * @details Waiting threads spin on a plain load of the lock word, which stays
+ *      in their cache, and only attempt the atomic exchange once the lock
+ *      has been observed free. This is the cheapest lock for critical
+ *      sections of a few instructions under low to moderate contention.
+ */
+class spin_lock
+{
+    private:
+        std::atomic<bool> _locked;
+
+    public:
+        spin_lock();
+        void lock();
+        void unlock();
+        bool is_locked();
+};
+
+/**
+ * @brief Constructor initializes the lock as free
+ */
+inline spin_lock::spin_lock()
+{
+    _locked.store(false, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Acquires the lock, spinning until it is free
+ */
+inline void spin_lock::lock()
+{
+    size_t spins = 0;
+    while(true)
+    {
+        if(!_locked.exchange(true, std::memory_order_acquire))
+            return;
+        while(_locked.load(std::memory_order_relaxed))
+            cpu_relax(spins);
+    }
+}
+
+/**
+ * @brief Releases the lock
+ */
+inline void spin_lock::unlock()
+{
+    _locked.store(false, std::memory_order_release);
+}
+
+/**
+ * @brief Determine whether the lock is currently held
+ * @return boolean value referring to whether the lock is held
+ */
+inline bool spin_lock::is_locked()
+{
+    return _locked.load(std::memory_order_seq_cst);
+}
+
+/**
+ * @class ticket_lock ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief A ticket lock granting the lock in first-come first-served order
+ * @details Each thread draws a ticket and waits until the ticket being
+ *      served is its own. Unlike the spin_lock, waiting threads are served
+ *      fairly under heavy contention.
+ */
+class ticket_lock
+{
+    private:
+        std::atomic<unsigned int> _next;
+        std::atomic<unsigned int> _serving;
+
+    public:
+        ticket_lock();
+        void lock();
+        void unlock();
+        bool is_locked();
+};
+
+/**
+ * @brief Constructor initializes the lock as free
+ */
+inline ticket_lock::ticket_lock()
+{
+    _next.store(0, std::memory_order_relaxed);
+    _serving.store(0, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Acquires the lock, waiting for all threads which arrived earlier
+ */
+inline void ticket_lock::lock()
+{
+    size_t spins = 0;
+    unsigned int ticket = _next.fetch_add(1, std::memory_order_relaxed);
+    while(_serving.load(std::memory_order_acquire) != ticket)
+        cpu_relax(spins);
+}
+
+/**
+ * @brief Releases the lock to the next ticket
+ */
+inline void ticket_lock::unlock()
+{
+    unsigned int ticket = _serving.load(std::memory_order_relaxed);
+    _serving.store(ticket + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Determine whether the lock is currently held
+ * @return boolean value referring to whether the lock is held
+ */
+inline bool ticket_lock::is_locked()
+{
+    return _next.load(std::memory_order_seq_cst) !=
+        _serving.load(std::memory_order_seq_cst);
+}
+
+/**
+ * @class mcs_lock ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief An MCS queue lock
+ * @details Waiting threads form a queue and each spins on a flag in its own
+ *      queue node, so that a release only invalidates the cache line of the
+ *      next waiter. Queue nodes are thread-local, hence a thread may hold at
+ *      most one mcs_lock at a time, which is the case for the insert locks
+ *      of parallel_hash_map.
+ */
+class mcs_lock
+{
+    struct qnode
+    {
+        std::atomic<qnode*> next;
+        std::atomic<bool> waiting;
+    };
+
+    private:
+        std::atomic<qnode*> _tail;
+        static qnode& local_node();
+
+    public:
+        mcs_lock();
+        void lock();
+        void unlock();
+        bool is_locked();
+};
+
+/**
+ * @brief Constructor initializes the lock as free with an empty queue
+ */
+inline mcs_lock::mcs_lock()
+{
+    _tail.store(NULL, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the queue node of the calling thread
+ * @return reference to the thread-local queue node
+ */
+inline mcs_lock::qnode& mcs_lock::local_node()
+{
+    static thread_local qnode node;
+    return node;
+}
+
+/**
+ * @brief Acquires the lock
+ * @details The thread appends its node to the queue. If the queue was not
+ *          empty, it links itself behind its predecessor and spins on its
+ *          own node until the predecessor hands the lock over.
+ */
+inline void mcs_lock::lock()
+{
+    qnode &node = local_node();
+    node.next.store(NULL, std::memory_order_relaxed);
+    node.waiting.store(true, std::memory_order_relaxed);
+
+    qnode *pred = _tail.exchange(&node, std::memory_order_acq_rel);
+    if(pred != NULL)
+    {
+        size_t spins = 0;
+        pred->next.store(&node, std::memory_order_release);
+        while(node.waiting.load(std::memory_order_acquire))
+            cpu_relax(spins);
+    }
+}
+
+/**
+ * @brief Releases the lock to the next thread in the queue
+ * @details If no successor is linked, the queue is emptied unless another
+ *          thread is in the middle of enqueuing, in which case the releasing
+ *          thread waits for the link to appear before handing over the lock.
+ */
+inline void mcs_lock::unlock()
+{
+    qnode &node = local_node();
+    qnode *succ = node.next.load(std::memory_order_acquire);
+    if(succ == NULL)
+    {
+        qnode *expected = &node;
+        if(_tail.compare_exchange_strong(expected, NULL,
+                std::memory_order_acq_rel))
+            return;
+        size_t spins = 0;
+        while((succ = node.next.load(std::memory_order_acquire)) == NULL)
+            cpu_relax(spins);
+    }
+    succ->waiting.store(false, std::memory_order_release);
+}
+
+/**
+ * @brief Determine whether the lock is currently held
+ * @return boolean value referring to whether the lock is held
+ */
+inline bool mcs_lock::is_locked()
+{
+    return _tail.load(std::memory_order_seq_cst) != NULL;
+}
+
+/**
+ * @class thread_registry ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief Assigns small, dense identifiers to the threads using the maps
+ * @details Each thread receives an identifier the first time it asks for
+ *      one, independently of the threading model: OpenMP threads of any
+ *      nesting level, threads executing OpenMP tasks and std::thread workers
+ *      are all handled alike. The identifier is stored in a thread-local
+ *      registration, which returns it to a free list when the thread exits so
+ *      that pools of short-lived threads keep identifiers small. Identifiers
+ *      are used to index the announce slots of the parallel_hash_map class.
+ */
+class thread_registry
+{
+    // registration of the calling thread, releasing its id on exit
+    struct registration
+    {
+        size_t id;
+        registration();
+        ~registration();
+    };
+
+    private:
+        static std::mutex& registry_lock();
+        static std::vector<size_t>& free_ids();
+        static size_t& num_ids();
+
+    public:
+        static size_t id();
+        static size_t max_threads();
+};
+
+/**
+ * @brief Returns the mutex guarding identifier assignment
+ * @return reference to the registry mutex
+ */
+inline std::mutex& thread_registry::registry_lock()
+{
+    static std::mutex lock;
+    return lock;
+}
+
+/**
+ * @brief Returns the identifiers released by exited threads
+ * @return reference to the list of free identifiers
+ */
+inline std::vector<size_t>& thread_registry::free_ids()
+{
+    static std::vector<size_t> ids;
+    return ids;
+}
+
+/**
+ * @brief Returns the number of identifiers handed out so far
+ * @return reference to the number of identifiers
+ */
+inline size_t& thread_registry::num_ids()
+{
+    static size_t count = 0;
+    return count;
+}
+
+/**
+ * @brief Registers the calling thread, reusing a released id if possible
+ */
+inline thread_registry::registration::registration()
+{
+    std::lock_guard<std::mutex> guard(registry_lock());
+    if(free_ids().empty())
+        id = num_ids()++;
+    else
+    {
+        id = free_ids().back();
+        free_ids().pop_back();
+    }
+}
+
+/**
+ * @brief Releases the id of an exiting thread
+ */
+inline thread_registry::registration::~registration()
+{
+    std::lock_guard<std::mutex> guard(registry_lock());
+    free_ids().push_back(id);
+}
+
+/**
+ * @brief Returns the identifier of the calling thread
+ * @details The identifier is assigned on the first call from each thread.
+ * @return identifier of the calling thread
+ */
+inline size_t thread_registry::id()
+{
+    static thread_local registration reg;
+    return reg.id;
+}
+
+/**
+ * @brief Returns the number of threads expected to run concurrently
+ * @details This is the OpenMP thread count if compiled with OpenMP and the
+ *          hardware concurrency otherwise. It is only a sizing hint: any
+ *          number of threads may use the maps.
+ * @return expected number of concurrent threads
+ */
+inline size_t thread_registry::max_threads()
+{
+    #ifdef OPENMP
+    return omp_get_max_threads();
+    #else
+    size_t num_threads = std::thread::hardware_concurrency();
+    return (num_threads > 0) ? num_threads : 1;
+    #endif
+}
+
+/**
+ * @brief Locates an element of an array stored in chunks of doubling size
+ * @details Chunk c holds B * 2^c elements, so element i lies in the chunk
+ *          given by the highest set bit of i / B + 1.
+ * @param i index of the element
+ * @param B number of elements in the first chunk
+ * @param chunk set to the chunk holding the element
+ * @param offset set to the position of the element within its chunk
+ */
+inline void locate_chunk(size_t i, size_t B, size_t &chunk, size_t &offset)
+{
+    size_t index = i / B + 1;
+    #if defined(__GNUC__)
+    chunk = 8 * sizeof(unsigned long) - 1 - __builtin_clzl(index);
+    #else
+    chunk = 0;
+    while(index >> (chunk + 1))
+        chunk++;
+    #endif
+    offset = i - B * ((1UL << chunk) - 1);
+}
+
+/**
+ * @class chunked_array ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief An append-only array growing in chunks of doubling size
+ * @details The first chunk holds B elements and every following chunk twice
+ *      as many as the previous one. Elements never move once allocated, so
+ *      threads may read elements while other threads grow the array. Chunks
+ *      are allocated by the first thread writing into them and published
+ *      with a compare-and-swap. Like table buckets, chunks are obtained from
+ *      <allocate_table_memory>, so large chunks are backed by huge pages
+ *      when available and are returned to the operating system when freed.
+ */
+template <class T, size_t B>
+class chunked_array
+{
+    enum {NUM_CHUNKS = 48};
+
+    private:
+        std::atomic<T*> _chunks[NUM_CHUNKS];
+        size_t _mapped[NUM_CHUNKS];     // length of each chunk mapping
+
+    public:
+        chunked_array();
+        virtual ~chunked_array();
+        T* allocate(size_t i);
+        T* get(size_t i);
+        T& operator[](size_t i);
+        void clear();
+        size_t memory_usage();
+};
+
+/**
+ * @brief Constructor initializes an array without any chunks
+ */
+template <class T, size_t B>
+chunked_array<T,B>::chunked_array()
+{
+    for(size_t c=0; c<NUM_CHUNKS; c++)
+    {
+        _chunks[c].store(NULL, std::memory_order_relaxed);
+        _mapped[c] = 0;
+    }
+}
+
+/**
+ * @brief Destructor frees all chunks
+ */
+template <class T, size_t B>
+chunked_array<T,B>::~chunked_array()
+{
+    clear();
+}
+
+/**
+ * @brief Returns an element, allocating its chunk if needed
+ * @details If the chunk holding the element is missing, it is allocated and
+ *          published unless another thread published it first. An exception
+ *          is thrown if the index lies beyond the last chunk.
+ * @param i index of the element
+ * @return pointer to the element
+ */
+template <class T, size_t B>
+T* chunked_array<T,B>::allocate(size_t i)
+{
+    size_t chunk, offset;
+    locate_chunk(i, B, chunk, offset);
+    if(chunk >= NUM_CHUNKS)
+        throw std::length_error("Too many elements for chunked_array");
+
+    // allocate the chunk if no other thread has
+    T *elements = _chunks[chunk].load(std::memory_order_acquire);
+    if(elements == NULL)
+    {
+        size_t length = B << chunk;
+        size_t mapped;
+        T *new_elements = (T*) allocate_table_memory(length * sizeof(T),
+                                                     mapped);
+        for(size_t i=0; i<length; i++)
+            new (&new_elements[i]) T;
+        if(_chunks[chunk].compare_exchange_strong(elements, new_elements,
+                std::memory_order_acq_rel))
+        {
+            elements = new_elements;
+            _mapped[chunk] = mapped;
+        }
+        else
+        {
+            for(size_t i=0; i<length; i++)
+                new_elements[i].~T();
+            free_table_memory(new_elements, mapped);
+        }
+    }
+    return &elements[offset];
+}
+
+/**
+ * @brief Returns an element if its chunk has been allocated
+ * @param i index of the element
+ * @return pointer to the element, NULL if its chunk is missing
+ */
+template <class T, size_t B>
+T* chunked_array<T,B>::get(size_t i)
+{
+    size_t chunk, offset;
+    locate_chunk(i, B, chunk, offset);
+    if(chunk >= NUM_CHUNKS)
+        return NULL;
+    T *elements = _chunks[chunk].load(std::memory_order_acquire);
+    if(elements == NULL)
+        return NULL;
+    return &elements[offset];
+}
+
+/**
+ * @brief Returns an element whose chunk is known to be allocated
+ * @param i index of the element
+ * @return reference to the element
+ */
+template <class T, size_t B>
+T& chunked_array<T,B>::operator[](size_t i)
+{
+    size_t chunk, offset;
+    locate_chunk(i, B, chunk, offset);
+    return _chunks[chunk].load(std::memory_order_acquire)[offset];
+}
+
+/**
+ * @brief Frees all chunks
+ * @details This function must not be called concurrently with other
+ *          operations on the array.
+ */
+template <class T, size_t B>
+void chunked_array<T,B>::clear()
+{
+    for(size_t c=0; c<NUM_CHUNKS; c++)
+    {
+        T *elements = _chunks[c].load(std::memory_order_relaxed);
+        if(elements == NULL)
+            continue;
+        for(size_t i=0; i<(B << c); i++)
+            elements[i].~T();
+        free_table_memory(elements, _mapped[c]);
+        _chunks[c].store(NULL, std::memory_order_relaxed);
+    }
+}
+
+/**
+ * @brief Returns the number of bytes used by the allocated chunks
+ * @return size of the chunks in bytes
+ */
+template <class T, size_t B>
+size_t chunked_array<T,B>::memory_usage()
+{
+    size_t bytes = 0;
+    for(size_t c=0; c<NUM_CHUNKS; c++)
+        if(_chunks[c].load(std::memory_order_relaxed) != NULL)
+            bytes += (B << c) * sizeof(T);
+    return bytes;
+}
+
+/**
+ * @brief Storage policies selecting where a table keeps its values
+ * @details With inline_storage each node holds its key, its value and the
+ *          link to the next node of its bucket. With split_storage the
+ *          values are kept in a separate array indexed like the nodes, so
+ *          that probes and key scans only touch keys and links. With
+ *          key_storage no values are kept at all, as for parallel_hash_set.
+ */
+struct inline_storage {};
+struct split_storage {};
+struct key_storage {};
+
+/**
+ * @brief Node of a fixed_hash_map for a given storage policy
+ * @details Nodes refer to the next node of their bucket by its index plus
+ *          one, zero terminating the bucket.
+ */
+template <class K, class V, class Storage>
+struct hash_node
+{
+    K key;
+    V value;
+    size_t next;
+};
+
+template <class K, class V>
+struct hash_node<K,V,split_storage>
+{
+    K key;
+    size_t next;
+};
+
+template <class K, class V>
+struct hash_node<K,V,key_storage>
+{
+    K key;
+    size_t next;
+};
+
+/**
+ * @brief Conflict resolution keeping the value already present in a table
+ * @details Used by default when merging tables. Any functor taking the
+ *          present value by reference and the incoming value may be used
+ *          instead, e.g. to add counts.
+ */
+struct keep_existing
+{
+    template <class V>
+    void operator()(V& existing, const V& incoming) const {}
+};
+
+/**
+ * @class fixed_hash_map ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief A fixed-size hash map supporting insertion and lookup operations
+ * @details The fixed_hash_map class supports insertion and lookup operations
+ *      but not deletion as deletion is not needed in the OpenMOC application. 
+ *      This hash table uses chaining for collisions and does not incorporate
+ *      concurrency objects except for tracking the number of entries in the
+ *      table for which an atomic increment is used. This hash table is not
+ *      thread safe but is used as a building block for the parallel_hash_map
+ *      class. This table guarantees O(1) insertions and lookups on avarge.
+ *      Optionally, a Bloom filter placed in front of the buckets rejects most
+ *      lookups of absent keys without touching the bucket array. Nodes are
+ *      not allocated one by one but stored in a chunked_array indexed by
+ *      their order number, which avoids a heap allocation and its overhead
+ *      per entry and lets the whole table be freed chunk by chunk. Where
+ *      values are kept is chosen by the Storage template parameter.
+ */
+template <class K, class V, class Storage = inline_storage>
+class fixed_hash_map
+{
+    typedef hash_node<K,V,Storage> node;
+
+    // nodes are stored in chunks of doubling size
+    enum {NODE_CHUNK = 32};
+
+    // returns the same value for every order number
+    struct constant_value
+    {
+        V value;
+        V operator()(int) { return value; }
+    };
+
+    // parallel maps merge tables under their own synchronization
+    template <class, class, class, class> friend class parallel_hash_map;
+
+    private:
+        size_t _M;          // table size
+        std::atomic<size_t> _N;     // number of elements present in table
+        size_t * _buckets;  // index plus one of the first node of each bucket
+        size_t _mapped;     // length of the bucket mapping (0 if on heap)
+        chunked_array<node, NODE_CHUNK> _nodes;     // nodes by order number
+        chunked_array<V, NODE_CHUNK> _values;       // values if split
+        V _no_value;        // value of every key if no values are stored
+        concurrent_bloom_filter<K> *_filter;    // optional negative filter
+        node* search(K key, size_t &index);
+        V& value_of(size_t index, node *n, inline_storage);
+        V& value_of(size_t index, node *n, split_storage);
+        V& value_of(size_t index, node *n, key_storage);
+        void store_value(size_t index, V value, inline_storage);
+        void store_value(size_t index, V value, split_storage);
+        void store_value(size_t index, V value, key_storage);
+        void link_node(K key, V value, size_t index);
+        template <class F> void merge_entry(K key, V value, F &resolve);
+
+    public:
+
+        fixed_hash_map(size_t M = 64, size_t F = 0);
+        virtual ~fixed_hash_map();
+        bool contains(K key);
+        V& at(K key);
+        bool find(K key, V& value);
+        void insert(K key, V value);
+        int insert_and_get_count(K key, V value);
+        template <class F> int insert_counted(K key, F make_value);
+        template <class F = keep_existing>
+        void merge(fixed_hash_map &source, F resolve = F());
+        template <class F = keep_existing>
+        void merge(fixed_hash_map &&source, F resolve = F());
+        size_t size();
+        size_t bucket_count();
+        K* keys();
+        V* values();
+        void clear();
+        void print_buckets();
+        size_t filter_bytes();
+        size_t memory_usage();
+};
+
+/**
+ * @class parallel_hash_map ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief A thread-safe hash map supporting insertion and lookup operations
+ * @details The parallel_hash_map class is built ontop of the fixed_hash_map
+ *      class, supporting insertion and lookup operations but not deletion as
+ *      deletion is not needed in the OpenMOC application. This hash table uses
+ *      chaining for collisions, as defined in fixed_hash_map. It offers lock
+ *      free lookups in O(1) time on average and fine-grained locking for
+ *      insertions in O(1) time on average as well. Resizing is conducted
+ *      periodically during inserts, although the starting table size can be
+ *      chosen to limit the number of resizing operations. A Bloom filter can
+ *      be enabled to speed up lookups that mostly miss; it is rebuilt along
+ *      with the table on every resize. Each lock stripe also carries a
+ *      sequence counter which writers bump, allowing <find> to return a
+ *      consistent copy of a value without taking any lock. The lock guarding
+ *      each stripe is chosen by the Lock template parameter (spin_lock,
+ *      ticket_lock or mcs_lock) and every stripe is padded to its own cache
+ *      lines. Announce slots are indexed by the thread_registry identifier
+ *      and allocated lazily, so the map may be used from nested OpenMP
+ *      regions, OpenMP tasks or std::thread workers alike. The Storage
+ *      template parameter selects the node layout of the underlying tables
+ *      (inline_storage, split_storage or key_storage).
+ */
+template <class K, class V, class Lock = spin_lock,
+          class Storage = inline_storage>
+class parallel_hash_map
+{
+    // padded pointer to hash table to avoid false sharing
+    struct paddedPointer
+    {
+        volatile long pad_L1;
+        volatile long pad_L2;
+        volatile long pad_L3;
+        volatile long pad_L4;
+        volatile long pad_L5;
+        volatile long pad_L7;
+        volatile long pad_L8;
+        std::atomic<fixed_hash_map<K,V,Storage>*> value;
+        volatile long pad_R1;
+        volatile long pad_R2;
+        volatile long pad_R3;
+        volatile long pad_R4;
+        volatile long pad_R5;
+        volatile long pad_R6;
+        volatile long pad_R7;
+        volatile long pad_R8;
+    };
+
+    // lock stripe and its sequence counter, padded to avoid false sharing
+    struct paddedStripe
+    {
+        volatile long pad_L1;
+        volatile long pad_L2;
+        volatile long pad_L3;
+        volatile long pad_L4;
+        volatile long pad_L5;
+        volatile long pad_L6;
+        volatile long pad_L7;
+        volatile long pad_L8;
+        Lock lock;
+        std::atomic<size_t> version;
+        volatile long pad_R1;
+        volatile long pad_R2;
+        volatile long pad_R3;
+        volatile long pad_R4;
+        volatile long pad_R5;
+        volatile long pad_R6;
+        volatile long pad_R7;
+        volatile long pad_R8;
+    };
+    // announce slots are allocated in chunks of doubling size
+    enum {ANNOUNCE_CHUNK = 64, NUM_ANNOUNCE_CHUNKS = 48};
+
+    private:
+        std::atomic<fixed_hash_map<K,V,Storage>*> _table;
+        std::atomic<paddedPointer*> _announce[NUM_ANNOUNCE_CHUNKS];
+        size_t _serial;
+        std::atomic<size_t> _N;
+        std::atomic<size_t> _M;
+        size_t _filter_bits;
+        paddedStripe *_stripes;
+        size_t _num_locks;
+        std::atomic<bool> _resizing;
+        size_t lock_stripe(K key, fixed_hash_map<K,V,Storage> *table_ptr);
+        void stop_inserts();
+        paddedPointer& announce_slot();
+        void wait_for_readers(fixed_hash_map<K,V,Storage> *table_ptr);
+        void swap_table(size_t M, bool copy, bool allow_inserts = true);
+        static size_t bucket_partition(size_t bucket, size_t bits);
+        static size_t* partition_pairs(const K* keys, size_t n, size_t M,
+                                       size_t num_blocks, size_t bits,
+                                       size_t *part_start);
+        void resize();
+
+    public:
+        parallel_hash_map(size_t M = 64, size_t L = 0, size_t F = 0);
+        virtual ~parallel_hash_map();
+        static parallel_hash_map* build(const K* keys, const V* values,
+                                        size_t n, int* counts = NULL,
+                                        size_t L = 0, size_t F = 0);
+        bool contains(K key);
+        V& at(K key);
+        bool find(K key, V& value);
+        void insert(K key, V value);
+        int insert_and_get_count(K key, V value);
+        template <class F> int insert_counted(K key, F make_value);
+        template <class F = keep_existing>
+        void merge_from(fixed_hash_map<K,V,Storage> &&source,
+                        F resolve = F());
+        template <class F = keep_existing>
+        void merge_from(fixed_hash_map<K,V,Storage> **sources,
+                        size_t num_sources, F resolve = F());
+        size_t size();
+        size_t bucket_count();
+        size_t num_locks();
+        K* keys();
+        V* values();
+        void clear();
+        void shrink_to_fit();
+        void print_buckets();
+        size_t filter_bytes();
+        size_t memory_usage();
+};
+
+/**
+ * @brief Constructor initializes fixed-size table of buckets filled with empty
+ *          linked lists.
+ * @details The constructor initializes a fixed-size hash map with the size
+ *          as an input parameter. If no size is given the default size (64)
+ *          is used. Buckets are filled with empty linked lists presented as
+ *          zero node references. Large bucket arrays are backed by huge pages
+ *          when available (see <allocate_table_memory>). If requested, a
+ *          Bloom filter sized for a load factor of 0.5 is also allocated.
+ * @param M size of fixed hash map
+ * @param F number of Bloom filter bits per key, zero disables the filter
+ */
+template <class K, class V, class Storage>
+fixed_hash_map<K,V,Storage>::fixed_hash_map(size_t M, size_t F)
+{
+    // ensure M is a power of 2
+    if( (M & (M-1)) != 0 )
+    {
+        // if not, round up to nearest power of 2
+        M--;
+        for(size_t i = 1; i < 8 * sizeof(size_t); i*=2)
+            M |= M >> i;
+        M++;
+    }
+
+    // allocate table
+    _M = M;
+    _N = 0;
+    _buckets = (size_t*) allocate_table_memory(_M * sizeof(size_t), _mapped);
+    _no_value = V();
+
+    // allocate filter
+    _filter = NULL;
+    if(F > 0)
+        _filter = new concurrent_bloom_filter<K>(_M / 2, F);
+}
+
+/**
+ * @brief Destructor deletes all nodes and the buckets of the fixed-size
+ *          table.
+ */
+template <class K, class V, class Storage>
+fixed_hash_map<K,V,Storage>::~fixed_hash_map()
+{
+    // delete all nodes chunk by chunk
+    _nodes.clear();
+    _values.clear();
+
+    // delete all buckets
+    free_table_memory(_buckets, _mapped);
+    delete _filter;
+} 
+
+/**
+ * @brief Searches the fixed-size table for a given key
+ * @details If the filter is enabled, it is checked first and rejects most
+ *          absent keys. Otherwise the linked list in the bucket associated
+ *          with the key is searched.
+ * @param key key to be searched
+ * @param index set to the index of the node holding the key, if present
+ * @return pointer to the node holding the key, NULL if it is not present
+ */
+template <class K, class V, class Storage>
+typename fixed_hash_map<K,V,Storage>::node*
+fixed_hash_map<K,V,Storage>::search(K key, size_t &index)
+{
+    // check filter for keys that are definitely absent
+    if(_filter != NULL && !_filter->may_contain(key))
+        return NULL;
+
+    // get hash into table assuming M is a power of 2, using fast modulus
+    size_t key_hash = std::hash<K>()(key) & (_M-1);
+
+    // search corresponding bucket for key
+    size_t ref = _buckets[key_hash];
+    while(ref != 0)
+    {
+        node *iter_node = &_nodes[ref-1];
+        if(iter_node->key == key)
+        {
+            index = ref - 1;
+            return iter_node;
+        }
+        ref = iter_node->next;
+    }
+    return NULL;
+}
+
+/**
+ * @brief Returns the value of a node for each storage policy
+ * @param index index of the node
+ * @param n pointer to the node
+ * @return reference to the value of the node
+ */
+template <class K, class V, class Storage>
+V& fixed_hash_map<K,V,Storage>::value_of(size_t index, node *n,
+                                         inline_storage)
+{
+    return n->value;
+}
+
+template <class K, class V, class Storage>
+V& fixed_hash_map<K,V,Storage>::value_of(size_t index, node *n,
+                                         split_storage)
+{
+    return _values[index];
+}
+
+template <class K, class V, class Storage>
+V& fixed_hash_map<K,V,Storage>::value_of(size_t index, node *n, key_storage)
+{
+    return _no_value;
+}
+
+/**
+ * @brief Stores the value of a new node for each storage policy
+ * @param index index of the node
+ * @param value value to be stored
+ */
+template <class K, class V, class Storage>
+void fixed_hash_map<K,V,Storage>::store_value(size_t index, V value,
+                                              inline_storage)
+{
+    _nodes[index].value = value;
+}
+
+template <class K, class V, class Storage>
+void fixed_hash_map<K,V,Storage>::store_value(size_t index, V value,
+                                              split_storage)
+{
+    *_values.allocate(index) = value;
+}
+
+template <class K, class V, class Storage>
+void fixed_hash_map<K,V,Storage>::store_value(size_t index, V value,
+                                              key_storage)
+{
+}
+
+/**
+ * @brief Determine whether the fixed-size table contains a given key
+ * @details The linked list in the bucket associated with the key is searched
+ *             to determine whether the key is present. If the filter is
+ *             enabled, it is checked first and rejects most absent keys.
+ * @param key key to be searched
+ * @return boolean value referring to whether the key is contained in the map
+ */
+template <class K, class V, class Storage>
+bool fixed_hash_map<K,V,Storage>::contains(K key)
+{
+    size_t index;
+    return search(key, index) != NULL;
+}
+
+/**
+ * @brief Determine the value associated with a given key in the fixed-size
+ *          table.
+ * @details The linked list in the bucket associated with the key is searched
+ *          and once the key is found, the corresponding value is returned.
+ *          An exception is thrown if the key is not present in the map.
+ * @param key key whose corresponding value is desired
+ * @return value associated with the given key
+ */
+template <class K, class V, class Storage>
+V& fixed_hash_map<K,V,Storage>::at(K key)
+{
+    // search bucket for key and return the corresponding value if found
+    size_t index;
+    node *key_node = search(key, index);
+    if(key_node != NULL)
+        return value_of(index, key_node, Storage());
+
+    // after the bucket has been completely searched without finding the key,
+    // throw an exception
+    throw std::out_of_range("Key not present in map");
+}
+
+
+/**
+ * @brief Copies the value associated with a given key in the fixed-size table.
+ * @details The linked list in the bucket associated with the key is searched
+ *          and once the key is found, the corresponding value is copied out.
+ *          Unlike <at>, no exception is thrown if the key is not present.
+ * @param key key whose corresponding value is desired
+ * @param value set to the value associated with the key if it is present
+ * @return boolean value referring to whether the key is contained in the map
+ */
+template <class K, class V, class Storage>
+bool fixed_hash_map<K,V,Storage>::find(K key, V& value)
+{
+    // search bucket for key and copy the corresponding value if found
+    size_t index;
+    node *key_node = search(key, index);
+    if(key_node == NULL)
+        return false;
+    value = value_of(index, key_node, Storage());
+    return true;
+}
+
+/**
+ * @brief Inserts a key/value pair into the fixed-size table.
+ * @details The specified key value pair is inserted into the fixed-size table.
+ *          If the key already exists in the table, the pair is not inserted
+ *          and the function returns.
+ * @param key key of the key/value pair to be inserted
+ * @param value value of the key/value pair to be inserted
+ */
+template <class K, class V, class Storage>
+void fixed_hash_map<K,V,Storage>::insert(K key, V value)
+{
+    constant_value make_value = {value};
+    insert_counted(key, make_value);
+    return;
+}
+
+/**
+ * @brief Inserts a key/value pair into the fixed-size table and returns the
+ *          order number with which it was inserted.
+ * @details The specified key value pair is inserted into the fixed-size table.
+ *          If the key already exists in the table, the pair is not inserted
+ *          and the function returns -1.
+ * @param key key of the key/value pair to be inserted
+ * @param key value of the key/value pair to be inserted
+ * @return order number in which key/value pair was inserted, -1 is returned if
+ *          key was already present in map.
+ */
+template <class K, class V, class Storage>
+int fixed_hash_map<K,V,Storage>::insert_and_get_count(K key, V value)
+{
+    constant_value make_value = {value};
+    return insert_counted(key, make_value);
+}
+
+/**
+ * @brief Inserts a key into the fixed-size table with a value derived from
+ *          the order number with which it is inserted.
+ * @details This function behaves like <insert_and_get_count> except that the
+ *          value is not known beforehand. The order number is claimed first
+ *          and passed to the functor, whose result is stored with the key.
+ *          The functor is only called if the key is absent and it runs
+ *          before the new node becomes visible to readers, so any side
+ *          effects it has are complete once the key can be found. The order
+ *          number is also the index of the new node.
+ * @param key key to be inserted
+ * @param make_value functor returning the value for a given order number
+ * @return order number in which the key was inserted, -1 is returned if the
+ *          key was already present in map.
+ */
+template <class K, class V, class Storage>
+template <class F>
+int fixed_hash_map<K,V,Storage>::insert_counted(K key, F make_value)
+{
+    // check to see if key already exisits in map
+    if(contains(key))
+        return -1;
+
+    // claim order number and place the key with the derived value
+    size_t index = _N++;
+    link_node(key, make_value((int) index), index);
+
+    return (int) index;
+}
+
+/**
+ * @brief Places a key/value pair in the node of a given order number
+ * @details The node is filled and linked at the end of the bucket of the
+ *          key. The key must be absent and the order number unused; neither
+ *          is checked and the number of entries is left to the caller.
+ * @param key key to be inserted
+ * @param value value to be inserted
+ * @param index order number of the new node
+ */
+template <class K, class V, class Storage>
+void fixed_hash_map<K,V,Storage>::link_node(K key, V value, size_t index)
+{
+    // get hash into table using fast modulus
+    size_t key_hash = std::hash<K>()(key) & (_M-1);
+
+    // fill the new node
+    node *new_node = _nodes.allocate(index);
+    new_node->key = key;
+    new_node->next = 0;
+    store_value(index, value, Storage());
+
+    // record key in filter before the node becomes visible
+    if(_filter != NULL)
+        _filter->insert(key);
+
+    // find where to place element in linked list
+    size_t *iter_ref = &_buckets[key_hash];
+    while(*iter_ref != 0)
+        iter_ref = &_nodes[*iter_ref - 1].next;
+
+    // order the node, value and filter bits before the link that publishes
+    // them, as the filter bits are set with relaxed atomics
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // place element in linked list
+    *iter_ref = index + 1;
+}
+
+/**
+ * @brief Merges a single entry into the fixed-size table
+ * @details If the key is absent, it is inserted with the given value.
+ *          Otherwise the conflict functor combines the incoming value into
+ *          the value present in the table.
+ * @param key key of the entry
+ * @param value value of the entry
+ * @param resolve functor called with the present and the incoming value
+ */
+template <class K, class V, class Storage>
+template <class F>
+void fixed_hash_map<K,V,Storage>::merge_entry(K key, V value, F &resolve)
+{
+    size_t index;
+    node *key_node = search(key, index);
+    if(key_node != NULL)
+        resolve(value_of(index, key_node, Storage()), value);
+    else
+        insert(key, value);
+}
+
+/**
+ * @brief Copies all entries of another fixed-size table into this table
+ * @details Entries are read directly from the buckets of the source table,
+ *          avoiding the copies made by <keys> and <values>. Both tables have
+ *          a power of 2 number of buckets, so with m the smaller of the two
+ *          numbers, a key whose hash is r modulo m lies in source and target
+ *          buckets which are r modulo m as well. With OpenMP these residue
+ *          classes are merged in parallel; every thread then writes to its
+ *          own buckets and no locking is needed. Keys present in both tables
+ *          are resolved by the functor, which may be called concurrently for
+ *          different keys. This table does not grow, so its load factor
+ *          rises with the merged entries.
+ * @param source table whose entries are copied
+ * @param resolve functor called with the present and the incoming value of
+ *          keys present in both tables
+ */
+template <class K, class V, class Storage>
+template <class F>
+void fixed_hash_map<K,V,Storage>::merge(fixed_hash_map &source, F resolve)
+{
+    size_t num_classes = std::min(_M, source._M);
+
+    #pragma omp parallel for schedule(dynamic, 16)
+    for(size_t r=0; r<num_classes; r++)
+    {
+        for(size_t b=r; b<source._M; b+=num_classes)
+        {
+            size_t ref = source._buckets[b];
+            while(ref != 0)
+            {
+                node *source_node = &source._nodes[ref-1];
+                merge_entry(source_node->key, source.value_of(ref-1,
+                            source_node, Storage()), resolve);
+                ref = source_node->next;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Moves all entries of another fixed-size table into this table
+ * @details The entries are merged as by the copying <merge>, after which
+ *          the source table is left empty.
+ * @param source table whose entries are moved
+ * @param resolve functor called with the present and the incoming value of
+ *          keys present in both tables
+ */
+template <class K, class V, class Storage>
+template <class F>
+void fixed_hash_map<K,V,Storage>::merge(fixed_hash_map &&source, F resolve)
+{
+    merge(source, resolve);
+    source.clear();
+}
+
+/**
+ * @brief Returns the number of key/value pairs in the fixed-size table
+ * @return number of key/value pairs in the map
+ */
+template <class K, class V, class Storage>
+size_t fixed_hash_map<K,V,Storage>::size()
+{
+    return _N;
+}
+
+/**
+ * @brief Returns the number of buckets in the fixed-size table
+ * @return number of buckets in the map
+ */
+template <class K, class V, class Storage>
+size_t fixed_hash_map<K,V,Storage>::bucket_count()
+{
+    return _M;
+}
+
+/**
+ * @brief Returns an array of the keys in the fixed-size table
+ * @details The nodes are scanned in order to form a list of all keys
+ *          present in the table and then the list is returned. Keys are
+ *          listed in the order in which they were inserted.
+ * @return an array of keys in the map whose length is the number of key/value
+ *          pairs in the table.
+*/
+template <class K, class V, class Storage>
+K* fixed_hash_map<K,V,Storage>::keys()
+{
+    // allocate array of keys
+    size_t N = _N;
+    K *key_list = new K[N];
+
+    // fill array with keys
+    for(size_t i=0; i<N; i++)
+        key_list[i] = _nodes[i].key;
+    return key_list;
+}
+
+/**
+ * @brief Returns an array of the values in the fixed-size table
+ * @details The nodes are scanned in order to form a list of all values
+ *          present in the table and then the list is returned. Values are
+ *          listed in the order in which they were inserted, matching
+ *          <keys>.
+ * @return an array of values in the map whose length is the number of 
+ *          key/value pairs in the table.
+*/
+template <class K, class V, class Storage>
+V* fixed_hash_map<K,V,Storage>::values()
+{
+    // allocate array of values
+    size_t N = _N;
+    V *values = new V[N];
+
+    // fill array with values
+    for(size_t i=0; i<N; i++)
+        values[i] = value_of(i, &_nodes[i], Storage());
+    return values;
+}
+
+/**
+ * @brief Clears all key/value pairs form the hash table.
+ * @details Nodes and split values are freed chunk by chunk. With OpenMP,
+ *          the buckets of large tables are reset to empty linked lists by
+ *          the threads of a new team.
+ */
+template <class K, class V, class Storage>
+void fixed_hash_map<K,V,Storage>::clear()
+{
+    // delete all nodes
+    _nodes.clear();
+    _values.clear();
+
+    // reset each bucket to an empty list
+    #pragma omp parallel for schedule(static) if(_M >= 0x01 << 16)
+    for(size_t i=0; i<_M; i++)
+        _buckets[i] = 0;
+
+    // reset filter
+    if(_filter != NULL)
+        _filter->clear();
+
+    // reset the number of entries to zero
+    _N = 0;
+    
+    return;
+}
+
+/**
+ * @brief Prints the contents of each bucket to the screen
+ * @details All buckets are scanned and the contents of the buckets are
+ *          printed, which are the indices of the first nodes of the linked
+ *          lists. If a linked list is empty, NULL is printed to the screen.
+ */
+template <class K, class V, class Storage>
+void fixed_hash_map<K,V,Storage>::print_buckets()
+{
+    for(size_t i=0; i<_M; i++)
+    {
+        if(_buckets[i] == 0)
+            std::cout << i << " -> NULL" << std::endl;
+        else
+            std::cout << i << " -> " << _buckets[i] - 1 << std::endl;
+    }
+}
+
+/**
+ * @brief Returns the memory used by the Bloom filter of the fixed-size table
+ * @return size of the filter in bytes, zero if the filter is disabled
+ */
+template <class K, class V, class Storage>
+size_t fixed_hash_map<K,V,Storage>::filter_bytes()
+{
+    if(_filter == NULL)
+        return 0;
+    return _filter->memory_usage();
+}
+
+/**
+ * @brief Returns the memory used by the fixed-size table
+ * @details The buckets, the node and value chunks and the filter are
+ *          counted.
+ * @return size of the table in bytes
+ */
+template <class K, class V, class Storage>
+size_t fixed_hash_map<K,V,Storage>::memory_usage()
+{
+    return _M * sizeof(size_t) + _nodes.memory_usage() +
+        _values.memory_usage() + filter_bytes();
+}
+
+/**
+ * @brief Constructor for generates initial underlying table as a fixed-sized 
+ *          hash map and intializes concurrency structures.
+ * @details The number of lock stripes is rounded up to a power of 2. If no
+ *          number is given, sixteen stripes are allocated per thread so that
+ *          concurrent inserts rarely contend on the same stripe.
+ * @param M initial size of the underlying table
+ * @param L number of locks guarding insertions, zero to size automatically
+ * @param F number of Bloom filter bits per key, zero disables the filter
+ */
+template <class K, class V, class Lock, class Storage>
+parallel_hash_map<K,V,Lock,Storage>::parallel_hash_map(size_t M, size_t L,
+                                                       size_t F)
+{
+    // allocate table
+    _filter_bits = F;
+    _table = new fixed_hash_map<K,V,Storage>(M, _filter_bits);
+
+    // entry and bucket counts are kept here so that reading them never
+    // touches a table which may be freed
+    _N.store(0, std::memory_order_relaxed);
+    _M.store(_table.load()->bucket_count(), std::memory_order_relaxed);
+
+    // create lock stripes, a power of 2 in number
+    if(L == 0)
+        L = 16 * thread_registry::max_threads();
+    _num_locks = 1;
+    while(_num_locks < L)
+        _num_locks *= 2;
+    _stripes = new paddedStripe[_num_locks];
+    for(size_t i=0; i<_num_locks; i++)
+        _stripes[i].version.store(0, std::memory_order_relaxed);
+    _resizing.store(false, std::memory_order_release);
+
+    // announce slots are allocated when threads first access the map
+    for(size_t i=0; i<NUM_ANNOUNCE_CHUNKS; i++)
+        _announce[i].store(NULL, std::memory_order_relaxed);
+
+    // give the map a serial number identifying it in thread-local caches
+    static std::atomic<size_t> num_maps(0);
+    _serial = ++num_maps;
+}
+
+/**
+ * @brief Destructor frees memory associated with fixed-sized hash map and
+ *          concurrency structures.
+ */
+template <class K, class V, class Lock, class Storage>
+parallel_hash_map<K,V,Lock,Storage>::~parallel_hash_map()
+{
+    delete _table.load();
+    delete[] _stripes;
+    for(size_t i=0; i<NUM_ANNOUNCE_CHUNKS; i++)
+        delete[] _announce[i].load();
+}
+
+/**
+ * @brief Returns the partition of a bucket during a bulk build
+ * @details The bucket index is scrambled by Fibonacci hashing before its
+ *          high bits are taken, so that keys with an identity hash which
+ *          occupy a narrow range of buckets still spread over all
+ *          partitions. Every bucket belongs to a single partition.
+ * @param bucket index of the bucket
+ * @param bits base 2 logarithm of the number of partitions
+ * @return index of the partition
+ */
+template <class K, class V, class Lock, class Storage>
+size_t parallel_hash_map<K,V,Lock,Storage>::bucket_partition(size_t bucket,
+                                                             size_t bits)
+{
+    if(bits == 0)
+        return 0;
+    return (size_t) (((unsigned long long) bucket * 0x9E3779B97F4A7C15ULL)
+        >> (64 - bits));
+}
+
+/**
+ * @brief Radix partitions pair indices by the bucket of their key
+ * @details With OpenMP, the input is split into blocks whose partition
+ *          histograms are counted in parallel; a prefix sum then gives every
+ *          block the offsets at which it scatters its pair indices, so
+ *          indices stay in input order within each partition.
+ * @param keys array of keys
+ * @param n number of keys
+ * @param M number of buckets of the table to be filled
+ * @param num_blocks number of blocks the input is split into
+ * @param bits base 2 logarithm of the number of partitions
+ * @param part_start array of length 2^bits + 1 set to the start of every
+ *          partition in the returned array
+ * @return array of the pair indices ordered by partition, to be deleted by
+ *          the caller
+ */
+template <class K, class V, class Lock, class Storage>
+size_t* parallel_hash_map<K,V,Lock,Storage>::partition_pairs(const K* keys,
+        size_t n, size_t M, size_t num_blocks, size_t bits,
+        size_t *part_start)
+{
+    size_t num_parts = 0x01UL << bits;
+
+    // count the pairs of every partition in every block of the input
+    size_t *offsets = new size_t[num_blocks * num_parts]();
+    #pragma omp parallel for schedule(static)
+    for(size_t b=0; b<num_blocks; b++)
+    {
+        size_t *block_counts = &offsets[b * num_parts];
+        for(size_t i=n*b/num_blocks; i<n*(b+1)/num_blocks; i++)
+        {
+            size_t key_hash = std::hash<K>()(keys[i]) & (M-1);
+            block_counts[bucket_partition(key_hash, bits)]++;
+        }
+    }
+
+    // turn counts into offsets, ordered by partition then block
+    size_t total = 0;
+    for(size_t p=0; p<num_parts; p++)
+    {
+        part_start[p] = total;
+        for(size_t b=0; b<num_blocks; b++)
+        {
+            size_t count = offsets[b * num_parts + p];
+            offsets[b * num_parts + p] = total;
+            total += count;
+        }
+    }
+    part_start[num_parts] = total;
+
+    // scatter pair indices, keeping input order within each partition
+    size_t *order = new size_t[n];
+    #pragma omp parallel for schedule(static)
+    for(size_t b=0; b<num_blocks; b++)
+    {
+        size_t *block_offsets = &offsets[b * num_parts];
+        for(size_t i=n*b/num_blocks; i<n*(b+1)/num_blocks; i++)
+        {
+            size_t key_hash = std::hash<K>()(keys[i]) & (M-1);
+            order[block_offsets[bucket_partition(key_hash, bits)]++] = i;
+        }
+    }
+
+    delete[] offsets;
+    return order;
+}
+
+/**
+ * @brief Builds a parallel hash map from arrays of keys and values
+ * @details Rather than inserting pairs one at a time, which takes a stripe
+ *          lock and checks for the key twice per pair, the pairs are radix
+ *          partitioned by their bucket (see <partition_pairs>) so that
+ *          every partition covers a disjoint set of buckets, and partitions
+ *          are filled in parallel without locking. This is done twice.
+ *          First the keys alone are inserted into a temporary set, each
+ *          partition in input order, which finds the first occurrence of
+ *          every key and the number of distinct keys. A blocked prefix sum
+ *          then numbers first occurrences in input order. Finally the map
+ *          is allocated with the table size a sequence of inserts of the
+ *          distinct keys would reach, and every first occurrence is placed
+ *          in the node of its order number. When a key is repeated its first
+ *          value is kept. Order numbers do not depend on the number of threads:
+ *          they are the numbers a sequence of <insert_and_get_count> calls
+ *          would return from a single thread, and they index the arrays
+ *          returned by <keys> and <values>.
+ * @param keys array of keys to be inserted
+ * @param values array of values to be inserted
+ * @param n number of key/value pairs
+ * @param counts array of length n set to the order number of each pair, -1
+ *          for repeated keys, or NULL if order numbers are not needed
+ * @param L number of lock stripes of the new map, zero to choose
+ *          automatically
+ * @param F number of Bloom filter bits per key, zero disables the filter
+ * @return a new map holding the pairs, to be deleted by the caller
+ */
+template <class K, class V, class Lock, class Storage>
+parallel_hash_map<K,V,Lock,Storage>* parallel_hash_map<K,V,Lock,Storage>::build(
+        const K* keys, const V* values, size_t n, int* counts, size_t L,
+        size_t F)
+{
+    // choose a power of 2 number of partitions, several per thread
+    size_t num_blocks = thread_registry::max_threads();
+    size_t bits = 0;
+    while((0x01UL << bits) < 4*num_blocks)
+        bits++;
+    size_t num_parts = 0x01UL << bits;
+    size_t *part_start = new size_t[num_parts + 1];
+
+    // find first occurrences by inserting the keys into a temporary set
+    char *first = new char[n];
+    size_t num_distinct;
+    {
+        fixed_hash_map<K,bool,key_storage> distinct(2*n);
+        size_t *order = partition_pairs(keys, n, distinct.bucket_count(),
+                                        num_blocks, bits, part_start);
+        #pragma omp parallel for schedule(dynamic)
+        for(size_t p=0; p<num_parts; p++)
+        {
+            for(size_t j=part_start[p]; j<part_start[p+1]; j++)
+            {
+                size_t i = order[j];
+                first[i] = distinct.insert_and_get_count(keys[i], true) >= 0;
+            }
+        }
+        num_distinct = distinct.size();
+        delete[] order;
+    }
+
+    // number first occurrences in input order with a blocked prefix sum
+    int *ranks = counts;
+    if(ranks == NULL)
+        ranks = new int[n];
+    size_t *block_sums = new size_t[num_blocks + 1]();
+    #pragma omp parallel for schedule(static)
+    for(size_t b=0; b<num_blocks; b++)
+        for(size_t i=n*b/num_blocks; i<n*(b+1)/num_blocks; i++)
+            block_sums[b+1] += first[i];
+    for(size_t b=0; b<num_blocks; b++)
+        block_sums[b+1] += block_sums[b];
+    #pragma omp parallel for schedule(static)
+    for(size_t b=0; b<num_blocks; b++)
+    {
+        size_t N = block_sums[b];
+        for(size_t i=n*b/num_blocks; i<n*(b+1)/num_blocks; i++)
+            ranks[i] = first[i] ? (int) N++ : -1;
+    }
+    delete[] block_sums;
+
+    // size the table as the resize rule of <insert_counted> would, which
+    // checks the size before each insert
+    size_t M = 64;
+    while(num_distinct > 0 && 2*(num_distinct-1) > M)
+        M *= 2;
+    parallel_hash_map *map = new parallel_hash_map(M, L, F);
+    fixed_hash_map<K,V,Storage> *table_ptr = map->_table.load();
+
+    // place first occurrences at their order numbers without locking
+    size_t *order = partition_pairs(keys, n, M, num_blocks, bits,
+                                    part_start);
+    #pragma omp parallel for schedule(dynamic)
+    for(size_t p=0; p<num_parts; p++)
+    {
+        for(size_t j=part_start[p]; j<part_start[p+1]; j++)
+        {
+            size_t i = order[j];
+            if(first[i])
+                table_ptr->link_node(keys[i], values[i], ranks[i]);
+        }
+    }
+    table_ptr->_N = num_distinct;
+    map->_N.store(num_distinct, std::memory_order_relaxed);
+
+    if(ranks != counts)
+        delete[] ranks;
+    delete[] part_start;
+    delete[] order;
+    delete[] first;
+    return map;
+}
+
+/**
+ * @brief Returns the announce slot of the calling thread
+ * @details Slots are indexed by the thread_registry identifier of the thread.
+ *          Chunk c holds the slots of identifiers ANNOUNCE_CHUNK * (2^c - 1)
+ *          to ANNOUNCE_CHUNK * (2^(c+1) - 1), so existing slots never move as
+ *          more threads arrive. A missing chunk is allocated by the first
+ *          thread needing it and published with a compare-and-swap. Each
+ *          thread caches the slot of the last map it accessed, keyed by the
+ *          map serial number rather than its address, which may be reused.
+ * @return reference to the announce slot of the calling thread
+ */
+template <class K, class V, class Lock, class Storage>
+typename parallel_hash_map<K,V,Lock,Storage>::paddedPointer&
+parallel_hash_map<K,V,Lock,Storage>::announce_slot()
+{
+    // check the slot cached by this thread
+    static thread_local size_t cached_serial = 0;
+    static thread_local paddedPointer *cached_slot = NULL;
+    if(cached_serial == _serial)
+        return *cached_slot;
+
+    // locate the chunk and offset of the thread identifier
+    size_t chunk, offset;
+    locate_chunk(thread_registry::id(), ANNOUNCE_CHUNK, chunk, offset);
+    if(chunk >= NUM_ANNOUNCE_CHUNKS)
+        throw std::length_error("Too many threads for parallel_hash_map");
+
+    // allocate the chunk if no other thread has
+    paddedPointer *slots = _announce[chunk].load(std::memory_order_acquire);
+    if(slots == NULL)
+    {
+        size_t num_slots = ANNOUNCE_CHUNK << chunk;
+        paddedPointer *new_slots = new paddedPointer[num_slots];
+        for(size_t i=0; i<num_slots; i++)
+            new_slots[i].value.store(NULL, std::memory_order_relaxed);
+        if(_announce[chunk].compare_exchange_strong(slots, new_slots,
+                std::memory_order_acq_rel))
+            slots = new_slots;
+        else
+            delete[] new_slots;
+    }
+
+    cached_serial = _serial;
+    cached_slot = &slots[offset];
+    return slots[offset];
+}
+
+/**
+ * @brief Waits until no thread announces that it is reading a given table
+ * @details A reader that allocated its chunk after the chunk was found
+ *          missing here necessarily loads the new table pointer afterwards,
+ *          so skipping missing chunks is safe.
+ * @param table_ptr table which is no longer referenced by the map
+ */
+template <class K, class V, class Lock, class Storage>
+void parallel_hash_map<K,V,Lock,Storage>::wait_for_readers(
+        fixed_hash_map<K,V,Storage> *table_ptr)
+{
+    size_t spins = 0;
+    for(size_t c=0; c<NUM_ANNOUNCE_CHUNKS; c++)
+    {
+        paddedPointer *slots = _announce[c].load(std::memory_order_seq_cst);
+        if(slots == NULL)
+            continue;
+        for(size_t i=0; i<(size_t) (ANNOUNCE_CHUNK << c); i++)
+            while(slots[i].value.load(std::memory_order_seq_cst) == table_ptr)
+                cpu_relax(spins);
+    }
+}
+
+/**
+ * @brief Determines the lock stripe guarding the bucket of a given key
+ * @details Since both the number of buckets and the number of stripes are
+ *          powers of 2, all keys of a bucket fall into the same stripe.
+ * @param key key whose stripe is desired
+ * @param table_ptr table into which the key is inserted
+ * @return index of the lock stripe
+ */
+template <class K, class V, class Lock, class Storage>
+size_t parallel_hash_map<K,V,Lock,Storage>::lock_stripe(K key,
+        fixed_hash_map<K,V,Storage> *table_ptr)
+{
+    return (std::hash<K>()(key) & (table_ptr->bucket_count() - 1)) &
+        (_num_locks - 1);
+}
+
+/**
+ * @brief Blocks all inserts into the table
+ * @details Rather than acquiring every stripe lock in turn, the thread raises
+ *          a global flag which inserting threads check after acquiring their
+ *          stripe lock. It then waits until every stripe has been observed
+ *          free once: any insert that acquired its stripe before the flag
+ *          was raised has finished, and any later one backs off. Both sides
+ *          fence between their store and their load so that at least one of
+ *          them observes the other, with inserters only paying for a
+ *          <light_fence>. The flag also excludes other threads wishing to
+ *          block inserts. It is lowered by storing false into _resizing.
+ */
+template <class K, class V, class Lock, class Storage>
+void parallel_hash_map<K,V,Lock,Storage>::stop_inserts()
+{
+    // raise the flag, waiting for any other resize or clear to finish
+    size_t spins = 0;
+    while(_resizing.exchange(true, std::memory_order_acquire))
+        cpu_relax(spins);
+    heavy_fence();
+
+    // wait for inserts in progress to leave their stripes
+    for(size_t i=0; i<_num_locks; i++)
+        while(_stripes[i].lock.is_locked())
+            cpu_relax(spins);
+}
+
+
+/**
+ * @brief Determine whether the parallel hash map contains a given key
+ * @details First the thread accessing the table announces its presence and
+ *          which table it is reading. Then the linked list in the bucket 
+ *          associated with the key is searched without setting any locks
+ *          to determine whether the key is present. When the thread has
+ *          finished accessing the table, the announcement is reset to NULL.
+ *          The announcement ensures that the data in the map is not freed
+ *          during a resize until all threads have finished accessing the map.
+ * @param key key to be searched
+ * @return boolean value referring to whether the key is contained in the map
+ */
+template <class K, class V, class Lock, class Storage>
+bool parallel_hash_map<K,V,Lock,Storage>::contains(K key)
+{
+    // get announce slot of this thread
+    paddedPointer &announce = announce_slot();
+
+    // get pointer to table, announce it will be searched, ensure consistency
+    fixed_hash_map<K,V,Storage> *table_ptr; 
+    do{
+        table_ptr = _table.load(std::memory_order_acquire);
+        announce.value.store(table_ptr, std::memory_order_relaxed);
+        light_fence();
+    } while(table_ptr != _table.load(std::memory_order_acquire));
+
+    // see if current table contains the thread
+    bool present = table_ptr->contains(key);
+    
+    // reset table announcement to not searching
+    announce.value.store(NULL, std::memory_order_release);
+    
+    return present;
+}
+
+/**
+ * @brief Determine the value associated with a given key.
+ * @details This function follows the same algorithm as <contains> except that
+ *          the value associated with the searched key is returned.
+ *          First the thread accessing the table announces its presence and
+ *          which table it is reading. Then the linked list in the bucket 
+ *          associated with the key is searched without setting any locks
+ *          to determine the associated value. An exception is thrown if the 
+ *          key is not found. When the thread has finished accessing the table, 
+ *          the announcement is reset to NULL. The announcement ensures that 
+ *          the data in the map is not freed during a resize until all threads 
+ *          have finished accessing the map.
+ * @param key key to be searched
+ * @return value associated with the key
+ */
+template <class K, class V, class Lock, class Storage>
+V& parallel_hash_map<K,V,Lock,Storage>::at(K key)
+{
+    // get announce slot of this thread
+    paddedPointer &announce = announce_slot();
+
+    // get pointer to table, announce it will be searched
+    fixed_hash_map<K,V,Storage> *table_ptr; 
+    do{
+        table_ptr = _table.load(std::memory_order_acquire);
+        announce.value.store(table_ptr, std::memory_order_relaxed);
+        light_fence();
+    } while(table_ptr != _table.load(std::memory_order_acquire));
+    
+    // get value associated with the key in the underlying table
+    V& value = table_ptr->at(key);
+    
+    // reset table announcement to not searching
+    announce.value.store(NULL, std::memory_order_release);
+    
+    return value;
+}
+
+/**
+ * @brief Copies the value associated with a given key into a snapshot.
+ * @details Unlike <at>, which returns a reference into the table that may be
+ *          read while another thread writes the same entry, this function
+ *          returns a consistent copy of the value. After announcing the table
+ *          it reads, the thread records the sequence counter of the lock
+ *          stripe covering the key, copies the value without setting any
+ *          locks and checks the counter again. Writers leave the counter odd
+ *          while they modify a stripe, so the read is retried only if the
+ *          counter was odd or changed in the meantime.
+ * @param key key to be searched
+ * @param value set to a consistent copy of the value associated with the key
+ * @return boolean value referring to whether the key is contained in the map
+ */
+template <class K, class V, class Lock, class Storage>
+bool parallel_hash_map<K,V,Lock,Storage>::find(K key, V& value)
+{
+    // get announce slot of this thread
+    paddedPointer &announce = announce_slot();
+
+    // get pointer to table, announce it will be searched
+    fixed_hash_map<K,V,Storage> *table_ptr; 
+    do{
+        table_ptr = _table.load(std::memory_order_acquire);
+        announce.value.store(table_ptr, std::memory_order_relaxed);
+        light_fence();
+    } while(table_ptr != _table.load(std::memory_order_acquire));
+
+    // copy value, retrying if a writer modified the stripe during the read
+    bool present;
+    size_t lock_hash = lock_stripe(key, table_ptr);
+    std::atomic<size_t> &version = _stripes[lock_hash].version;
+    size_t spins = 0;
+    while(true)
+    {
+        size_t start = version.load(std::memory_order_acquire);
+        if(start & 1)
+        {
+            cpu_relax(spins);
+            continue;
+        }
+        present = table_ptr->find(key, value);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if(version.load(std::memory_order_relaxed) == start)
+            break;
+    }
+
+    // reset table announcement to not searching
+    announce.value.store(NULL, std::memory_order_release);
+
+    return present;
+}
+
+/**
+ * @brief Insert a given key/value pair into the parallel hash map.
+ * @details The key/value pair is inserted with <insert_counted>. If the key
+ *          is already contained in the map, the pair is not inserted.
+ * @param key key of the key/value pair to be inserted
+ * @param value value of the key/value pair to be inserted
+ */
+template <class K, class V, class Lock, class Storage>
+void parallel_hash_map<K,V,Lock,Storage>::insert(K key, V value)
+{
+    typename fixed_hash_map<K,V,Storage>::constant_value make_value = {value};
+    insert_counted(key, make_value);
+    return;
+}
+
+/**
+ * @brief Insert a given key/value pair into the parallel hash map and return
+            the order number.
+ * @details The key/value pair is inserted with <insert_counted>. If the key
+ *          is already contained in the map, the pair is not inserted and the
+ *          function returns -1.
+ * @param key key of the key/value pair to be inserted
+ * @param value value of the key/value pair to be inserted
+ * @return order number in which the key/value pair was inserted, -1 if it
+ *          already exists
+ */
+template <class K, class V, class Lock, class Storage>
+int parallel_hash_map<K,V,Lock,Storage>::insert_and_get_count(K key, V value)
+{
+    typename fixed_hash_map<K,V,Storage>::constant_value make_value = {value};
+    return insert_counted(key, make_value);
+}
+
+/**
+ * @brief Insert a key into the parallel hash map with a value derived from
+ *          the order number with which it is inserted.
+ * @details First the underlying table is checked to determine if a resize
+ *          should be conducted. Then, the table is checked to see if it
+ *          already contains the key. If so, the key is not inserted and the
+ *          function returns. Otherwise, the lock of the associated stripe is
+ *          acquired once inserts are allowed and the key is added to the
+ *          table. The functor is called with the order number while the
+ *          stripe lock is held and before the key becomes visible, see
+ *          fixed_hash_map::insert_counted. Order numbers are dense: they
+ *          count the successful inserts into the map, including across
+ *          resizes.
+ * @param key key to be inserted
+ * @param make_value functor returning the value for a given order number
+ * @return order number in which the key was inserted, -1 if it already
+ *          exists
+ */
+template <class K, class V, class Lock, class Storage>
+template <class F>
+int parallel_hash_map<K,V,Lock,Storage>::insert_counted(K key, F make_value)
+{
+    // check if resize needed
+    if(2*size() > bucket_count())
+        resize();
+
+    // check to see if key is already contained in the table
+    if(contains(key))
+        return -1;
+
+    // get announce slot of this thread
+    paddedPointer &announce = announce_slot();
+
+    // acquire the stripe lock once inserts are allowed into the current
+    // table, then mark the stripe as being written. The table is announced
+    // before its bucket count picks the stripe, so that a concurrent resize
+    // cannot free it in the meantime.
+    fixed_hash_map<K,V,Storage> *table_ptr;
+    size_t lock_hash;
+    size_t spins = 0;
+    while(true)
+    {
+        while(_resizing.load(std::memory_order_acquire))
+            cpu_relax(spins);
+        do{
+            table_ptr = _table.load(std::memory_order_acquire);
+            announce.value.store(table_ptr, std::memory_order_relaxed);
+            light_fence();
+        } while(table_ptr != _table.load(std::memory_order_acquire));
+        lock_hash = lock_stripe(key, table_ptr);
+        _stripes[lock_hash].lock.lock();
+        light_fence();
+        if(!_resizing.load(std::memory_order_relaxed) && table_ptr == _table)
+            break;
+        _stripes[lock_hash].lock.unlock();
+        announce.value.store(NULL, std::memory_order_release);
+    }
+    std::atomic<size_t> &version = _stripes[lock_hash].version;
+    size_t start = version.load(std::memory_order_relaxed);
+    version.store(start + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    // insert key with its derived value
+    int N = table_ptr->insert_counted(key, make_value);
+    if(N >= 0)
+        _N.fetch_add(1, std::memory_order_relaxed);
+
+    // mark the stripe as consistent and release lock
+    version.store(start + 2, std::memory_order_release);
+    _stripes[lock_hash].lock.unlock();
+
+    // reset table announcement to not searching
+    announce.value.store(NULL, std::memory_order_release);
+
+    return N;
+}
+
+/**
+ * @brief Moves all entries of a fixed-size table into the map
+ * @details See the version of this function merging several tables.
+ * @param source table whose entries are moved
+ * @param resolve functor called with the present and the incoming value of
+ *          keys present in both tables
+ */
+template <class K, class V, class Lock, class Storage>
+template <class F>
+void parallel_hash_map<K,V,Lock,Storage>::merge_from(
+        fixed_hash_map<K,V,Storage> &&source, F resolve)
+{
+    fixed_hash_map<K,V,Storage> *sources[1] = {&source};
+    merge_from(sources, 1, resolve);
+}
+
+/**
+ * @brief Moves all entries of several fixed-size tables into the map
+ * @details This is the combining step of a map-reduce style build: threads
+ *          fill private fixed_hash_map tables without any synchronization
+ *          and then merge them into a shared map. Inserts are stopped during
+ *          the merge and the table is first grown, if needed, so that the
+ *          entries of all sources fit without a resize. Each source is then
+ *          merged as in fixed_hash_map::merge, by residue classes of the key
+ *          hash modulo the smallest of the two bucket counts and the number
+ *          of lock stripes, so that every thread writes its own buckets and
+ *          stripes without locking. Lookups may proceed during the merge:
+ *          every merged entry bumps the sequence counter of its stripe,
+ *          which keeps <find> consistent when a present value is resolved.
+ *          The source tables are left empty.
+ * @param sources array of pointers to the tables whose entries are moved
+ * @param num_sources number of tables
+ * @param resolve functor called with the present and the incoming value of
+ *          keys present in both tables
+ */
+template <class K, class V, class Lock, class Storage>
+template <class F>
+void parallel_hash_map<K,V,Lock,Storage>::merge_from(
+        fixed_hash_map<K,V,Storage> **sources, size_t num_sources,
+        F resolve)
+{
+    // block inserts
+    stop_inserts();
+
+    // grow the table once so that the entries of all sources fit
+    size_t num_entries = size();
+    for(size_t s=0; s<num_sources; s++)
+        num_entries += sources[s]->size();
+    size_t M = bucket_count();
+    while(M < 2*num_entries)
+        M *= 2;
+    if(M > bucket_count())
+        swap_table(M, true, false);
+
+    // merge residue classes in parallel, marking the stripe of every entry
+    fixed_hash_map<K,V,Storage> *table_ptr = _table;
+    for(size_t s=0; s<num_sources; s++)
+    {
+        fixed_hash_map<K,V,Storage> &source = *sources[s];
+        size_t num_classes = std::min(std::min(M, source._M), _num_locks);
+        #pragma omp parallel for schedule(dynamic, 16)
+        for(size_t r=0; r<num_classes; r++)
+        {
+            for(size_t b=r; b<source._M; b+=num_classes)
+            {
+                size_t ref = source._buckets[b];
+                while(ref != 0)
+                {
+                    typename fixed_hash_map<K,V,Storage>::node *source_node =
+                        &source._nodes[ref-1];
+                    K key = source_node->key;
+                    std::atomic<size_t> &version =
+                        _stripes[lock_stripe(key, table_ptr)].version;
+                    size_t start = version.load(std::memory_order_relaxed);
+                    version.store(start + 1, std::memory_order_relaxed);
+                    std::atomic_thread_fence(std::memory_order_release);
+                    table_ptr->merge_entry(key, source.value_of(ref-1,
+                                source_node, Storage()), resolve);
+                    version.store(start + 2, std::memory_order_release);
+                    ref = source_node->next;
+                }
+            }
+        }
+        source.clear();
+    }
+    _N.store(table_ptr->size(), std::memory_order_relaxed);
+
+    // allow inserts
+    _resizing.store(false, std::memory_order_release);
+
+    return;
+}
+
+/**
+ * @brief Resizes the underlying table to twice its current capacity.
+ * @details In a thread-safe manner, this procedure resizes the underlying
+ *      fixed_hash_map table to twice its current capacity using the insert
+ *      flag and the announce array. First, inserts are blocked with
+ *      <stop_inserts>. If another thread is already resizing the table, the
+ *      function returns immediately and the caller waits for that resize
+ *      when it attempts to insert. A new table is allocated of twice the
+ *      size and all key/value pairs from the old table, then the pointer is
+ *      switched to the new table and inserts are allowed again. Finally the
+ *      memory needs to be freed. To prevent threads currently reading the
+ *      table from encountering segmentation faults, the resizing threads
+ *      waits for the announce array to be free of references to the old
+ *      table before freeing the memory.
+ */
+template <class K, class V, class Lock, class Storage>
+void parallel_hash_map<K,V,Lock,Storage>::resize()
+{
+    // leave the resize to the thread already blocking inserts
+    if(_resizing.load(std::memory_order_relaxed))
+        return;
+
+    // block inserts
+    stop_inserts();
+
+    // recheck if resize needed
+    if(2*size() < bucket_count())
+    {
+        // allow inserts
+        _resizing.store(false, std::memory_order_release);
+        return;
+    }
+
+    // move the key/value pairs to a new table of double the size
+    swap_table(2*bucket_count(), true);
+
+    return;
+}
+
+/**
+ * @brief Replaces the underlying table by a new table
+ * @details This function must be called by the thread which stopped inserts
+ *          with <stop_inserts>. A new table of the requested size is
+ *          allocated and, if requested, all key/value pairs from the old
+ *          table are inserted into it. Then the pointer is switched to the
+ *          new table and, unless the caller keeps them stopped, inserts are
+ *          allowed again. Finally the old table is freed once the announce
+ *          array is free of references to it.
+ * @param M number of buckets of the new table
+ * @param copy whether the key/value pairs are moved to the new table
+ * @param allow_inserts whether inserts are allowed again afterwards
+ */
+template <class K, class V, class Lock, class Storage>
+void parallel_hash_map<K,V,Lock,Storage>::swap_table(size_t M, bool copy,
+                                                     bool allow_inserts)
+{
+    // allocate new hash map
+    fixed_hash_map<K,V,Storage> *new_map =
+        new fixed_hash_map<K,V,Storage>(M, _filter_bits);
+
+    // save pointer of old table
+    fixed_hash_map<K,V,Storage> *old_table = _table;
+
+    // insert key/value pairs into new hash map
+    if(copy)
+    {
+        K *key_list = old_table->keys();
+        V *value_list = old_table->values();
+        for(size_t i=0; i<old_table->size(); i++)
+            new_map->insert(key_list[i], value_list[i]);
+        delete[] key_list;
+        delete[] value_list;
+    }
+
+    // reassign pointer and counts, then allow inserts
+    _N.store(new_map->size(), std::memory_order_relaxed);
+    _M.store(M, std::memory_order_relaxed);
+    _table = new_map;
+    if(allow_inserts)
+        _resizing.store(false, std::memory_order_release);
+
+    // wait for all threads to stop reading from the old table
+    heavy_fence();
+    wait_for_readers(old_table);
+
+    // free memory associated with old table
+    delete old_table;
+}
+
+/**
+ * @brief Returns the number of key/value pairs in the underlying table
+ * @details The count is kept by the map rather than read from the table,
+ *          which another thread may free during a resize or <clear>. It
+ *          includes every completed insert.
+ * @return number of key/value pairs in the map
+ */
+template <class K, class V, class Lock, class Storage>
+size_t parallel_hash_map<K,V,Lock,Storage>::size()
+{
+    return _N.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the number of buckets in the underlying table
+ * @details As with <size>, the count is kept by the map.
+ * @return number of buckets in the map
+ */
+template <class K, class V, class Lock, class Storage>
+size_t parallel_hash_map<K,V,Lock,Storage>::bucket_count()
+{
+    return _M.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the number of locks in the parallel hash map
+ * @return number of locks in the map
+ */
+template <class K, class V, class Lock, class Storage>
+size_t parallel_hash_map<K,V,Lock,Storage>::num_locks()
+{
+    return _num_locks;
+}
+
+/**
+ * @brief Returns an array of the keys in the underlying table
+ * @details All buckets are scanned in order to form a list of all keys
+ *          present in the table and then the list is returned. Threads
+ *          announce their presence to ensure table memory is not freed
+ *          during access.
+ * @return an array of keys in the map whose length is the number of key/value
+ *          pairs in the table.
+ */
+template <class K, class V, class Lock, class Storage>
+K* parallel_hash_map<K,V,Lock,Storage>::keys()
+{
+    // get announce slot of this thread
+    paddedPointer &announce = announce_slot();
+
+    // get pointer to table, announce it will be searched
+    fixed_hash_map<K,V,Storage> *table_ptr; 
+    do{
+        table_ptr = _table.load(std::memory_order_acquire);
+        announce.value.store(table_ptr, std::memory_order_relaxed);
+        light_fence();
+    } while(table_ptr != _table.load(std::memory_order_acquire));
+
+    // get key list
+    K* key_list = table_ptr->keys();
+
+    // reset table announcement to not searching
+    announce.value.store(NULL, std::memory_order_release);
+
+    return key_list;
+}
+
+/**
+ * @brief Returns an array of the values in the underlying table
+ * @details All buckets are scanned in order to form a list of all values
+ *          present in the table and then the list is returned. Threads
+ *          announce their presence to ensure table memory is not freed
+ *          during access.
+ * @return an array of values in the map whose length is the number of key/value
+ *          pairs in the table.
+ */
+template <class K, class V, class Lock, class Storage>
+V* parallel_hash_map<K,V,Lock,Storage>::values()
+{
+    // get announce slot of this thread
+    paddedPointer &announce = announce_slot();
+
+    // get pointer to table, announce it will be searched
+    fixed_hash_map<K,V,Storage> *table_ptr; 
+    do{
+        table_ptr = _table.load(std::memory_order_acquire);
+        announce.value.store(table_ptr, std::memory_order_relaxed);
+        light_fence();
+    } while(table_ptr != _table.load(std::memory_order_acquire));
+
+    // get value list
+    V* value_list = table_ptr->values();
+    
+    // reset table announcement to not searching
+    announce.value.store(NULL, std::memory_order_release);
+
+    return value_list;
+}
+
+/**
+ * @brief Clears all key/value pairs form the hash table.
+ * @details Rather than emptying the current table while other threads may
+ *          still read it, inserts are stopped only long enough to switch to
+ *          an empty table of the same size. Its buckets come zeroed from the
+ *          allocator, so refilling the map to its previous size causes no
+ *          resize. The old table is freed once no thread reads it, which
+ *          releases its nodes chunk by chunk without visiting its buckets.
+ */
+template <class K, class V, class Lock, class Storage>
+void parallel_hash_map<K,V,Lock,Storage>::clear()
+{
+    // block inserts
+    stop_inserts();
+
+    // switch to an empty table, allow inserts and free the old table
+    swap_table(bucket_count(), false);
+
+    return;
+}
+
+/**
+ * @brief Shrinks the underlying table to the smallest size for its contents
+ * @details After a peak in the number of entries, e.g. once the map has been
+ *          cleared, the table is rebuilt with the smallest power of 2 number
+ *          of buckets (at least 64) that keeps the load factor at or below
+ *          0.5. Inserts are stopped during the rebuild. Afterwards, freed
+ *          node memory is handed back to the operating system when glibc is
+ *          used; large bucket arrays are unmapped when their table is freed.
+ */
+template <class K, class V, class Lock, class Storage>
+void parallel_hash_map<K,V,Lock,Storage>::shrink_to_fit()
+{
+    // block inserts
+    stop_inserts();
+
+    // find the smallest table which does not need a resize
+    size_t M = 64;
+    while(M < 2*size())
+        M *= 2;
+
+    // move the key/value pairs to the smaller table
+    if(M < bucket_count())
+        swap_table(M, true);
+    else
+        _resizing.store(false, std::memory_order_release);
+
+    // return free heap memory to the operating system
+    #ifdef __GLIBC__
+    malloc_trim(0);
+    #endif
+
+    return;
+}
+
+/**
+ * @brief Prints the contents of each bucket to the screen
+ * @details All buckets are scanned and the contents of the buckets are
+ *          printed, which are pointers to linked lists. If the pointer is NULL
+ *          suggesting that the linked list is empty, NULL is printed to the
+ *          screen. Threads announce their presence to ensure table memory is
+ *          not freed during access.
+ */
+template <class K, class V, class Lock, class Storage>
+void parallel_hash_map<K,V,Lock,Storage>::print_buckets()
+{
+    // get announce slot of this thread
+    paddedPointer &announce = announce_slot();
+
+    // get pointer to table, announce it will be searched
+    fixed_hash_map<K,V,Storage> *table_ptr; 
+    do{
+        table_ptr = _table.load(std::memory_order_acquire);
+        announce.value.store(table_ptr, std::memory_order_relaxed);
+        light_fence();
+    } while(table_ptr != _table.load(std::memory_order_acquire));
+        
+    // print buckets
+    table_ptr->print_buckets();
+
+    // reset table announcement to not searching
+    announce.value.store(NULL, std::memory_order_release);
+    
+    return;
+}
+
+/**
+ * @brief Returns the memory used by the Bloom filter of the underlying table
+ * @return size of the filter in bytes, zero if the filter is disabled
+ */
+template <class K, class V, class Lock, class Storage>
+size_t parallel_hash_map<K,V,Lock,Storage>::filter_bytes()
+{
+    // get announce slot of this thread
+    paddedPointer &announce = announce_slot();
+
+    // get pointer to table, announce it will be searched
+    fixed_hash_map<K,V,Storage> *table_ptr;
+    do{
+        table_ptr = _table.load(std::memory_order_acquire);
+        announce.value.store(table_ptr, std::memory_order_relaxed);
+        light_fence();
+    } while(table_ptr != _table.load(std::memory_order_acquire));
+
+    // get filter size
+    size_t bytes = table_ptr->filter_bytes();
+
+    // reset table announcement to not searching
+    announce.value.store(NULL, std::memory_order_release);
+
+    return bytes;
+}
+
+/**
+ * @brief Returns the memory used by the map
+ * @details The underlying table and the lock stripes are counted.
+ * @return size of the map in bytes
+ */
+template <class K, class V, class Lock, class Storage>
+size_t parallel_hash_map<K,V,Lock,Storage>::memory_usage()
+{
+    // get announce slot of this thread
+    paddedPointer &announce = announce_slot();
+
+    // get pointer to table, announce it will be searched
+    fixed_hash_map<K,V,Storage> *table_ptr;
+    do{
+        table_ptr = _table.load(std::memory_order_acquire);
+        announce.value.store(table_ptr, std::memory_order_relaxed);
+        light_fence();
+    } while(table_ptr != _table.load(std::memory_order_acquire));
+
+    // get table size
+    size_t bytes = table_ptr->memory_usage();
+
+    // reset table announcement to not searching
+    announce.value.store(NULL, std::memory_order_release);
+
+    return bytes + _num_locks * sizeof(paddedStripe);
+}
+
+/**
+ * @class parallel_hash_set ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief A thread-safe hash set supporting insertion and lookup operations
+ * @details The parallel_hash_set class is a parallel_hash_map using the
+ *      key_storage policy, so that every entry only holds its key and the
+ *      link to the next entry of its bucket. Lookups are lock free and
+ *      inserts, resizing and the optional Bloom filter behave as in the map.
+ */
+template <class K, class Lock = spin_lock>
+class parallel_hash_set
+{
+    private:
+        parallel_hash_map<K,bool,Lock,key_storage> _map;
+
+    public:
+        parallel_hash_set(size_t M = 64, size_t L = 0, size_t F = 0);
+        virtual ~parallel_hash_set();
+        bool contains(K key);
+        void insert(K key);
+        int insert_and_get_count(K key);
+        size_t size();
+        size_t bucket_count();
+        K* keys();
+        void clear();
+        void shrink_to_fit();
+        size_t memory_usage();
+};
+
+/**
+ * @brief Constructor initializes an empty set
+ * @param M initial number of buckets
+ * @param L number of locks guarding insertions, zero to size automatically
+ * @param F number of Bloom filter bits per key, zero disables the filter
+ */
+template <class K, class Lock>
+parallel_hash_set<K,Lock>::parallel_hash_set(size_t M, size_t L, size_t F)
+    : _map(M, L, F)
+{
+}
+
+/**
+ * @brief Destructor frees the underlying map
+ */
+template <class K, class Lock>
+parallel_hash_set<K,Lock>::~parallel_hash_set()
+{
+}
+
+/**
+ * @brief Determine whether the set contains a given key
+ * @param key key to be searched
+ * @return boolean value referring to whether the key is contained in the set
+ */
+template <class K, class Lock>
+bool parallel_hash_set<K,Lock>::contains(K key)
+{
+    return _map.contains(key);
+}
+
+/**
+ * @brief Insert a given key into the set
+ * @param key key to be inserted
+ */
+template <class K, class Lock>
+void parallel_hash_set<K,Lock>::insert(K key)
+{
+    _map.insert(key, true);
+}
+
+/**
+ * @brief Insert a given key into the set and return the order number
+ * @param key key to be inserted
+ * @return order number in which the key was inserted, -1 if it already
+ *          exists
+ */
+template <class K, class Lock>
+int parallel_hash_set<K,Lock>::insert_and_get_count(K key)
+{
+    return _map.insert_and_get_count(key, true);
+}
+
+/**
+ * @brief Returns the number of keys in the set
+ * @return number of keys in the set
+ */
+template <class K, class Lock>
+size_t parallel_hash_set<K,Lock>::size()
+{
+    return _map.size();
+}
+
+/**
+ * @brief Returns the number of buckets in the underlying table
+ * @return number of buckets
+ */
+template <class K, class Lock>
+size_t parallel_hash_set<K,Lock>::bucket_count()
+{
+    return _map.bucket_count();
+}
+
+/**
+ * @brief Returns an array of the keys in the set
+ * @return an array of keys whose length is the number of keys in the set
+ */
+template <class K, class Lock>
+K* parallel_hash_set<K,Lock>::keys()
+{
+    return _map.keys();
+}
+
+/**
+ * @brief Clears all keys from the set
+ */
+template <class K, class Lock>
+void parallel_hash_set<K,Lock>::clear()
+{
+    _map.clear();
+}
+
+/**
+ * @brief Shrinks the underlying table to the smallest size for its contents
+ */
+template <class K, class Lock>
+void parallel_hash_set<K,Lock>::shrink_to_fit()
+{
+    _map.shrink_to_fit();
+}
+
+/**
+ * @brief Returns the memory used by the set
+ * @return size of the set in bytes
+ */
+template <class K, class Lock>
+size_t parallel_hash_set<K,Lock>::memory_usage()
+{
+    return _map.memory_usage();
+}
+
 
 /**
- * @class fixed_hash_map ParallelHashMap.h "src/ParallelHashMap.h"
- * @brief A fixed-size hash map supporting insertion and lookup operations
- * @details The fixed_hash_map class supports insertion and lookup operations
- *      but not deletion as deletion is not needed in the OpenMOC application. 
- *      This hash table uses chaining for collisions and does not incorporate
- *      concurrency objects except for tracking the number of entries in the
- *      table for which an atomic increment is used. This hash table is not
- *      thread safe but is used as a building block for the parallel_hash_map
- *      class. This table guarantees O(1) insertions and lookups on avarge.
+ * @class concurrent_interner ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief A thread-safe dictionary assigning dense integer identifiers to keys
+ * @details The concurrent_interner class maps every distinct key to an
+ *      identifier in [0, size()) which never changes once assigned. Keys are
+ *      held in a parallel_hash_map whose values are the identifiers, which
+ *      are the order numbers handed out by insert_counted. Each new key is
+ *      also written into an append-only array indexed by identifier, giving
+ *      the reverse lookup in O(1). This array is allocated in chunks of
+ *      doubling size so that it grows without moving keys that other threads
+ *      may be reading. The key is written before it becomes visible in the
+ *      map, so any thread which obtained an identifier may look its key up.
  */
-template <class K, class V>
-class fixed_hash_map
+template <class K, class Lock = spin_lock>
+class concurrent_interner
 {
-    struct node
+    // keys are stored in chunks of doubling size
+    enum {KEY_CHUNK = 1024};
+
+    // key of an identifier, flagged once it has been written
+    struct key_slot
     {
-        node(K k_in, V v_in) : next(NULL), key(k_in), value(v_in){}
         K key;
-        V value;
-        node *next;
+        std::atomic<bool> published;
+        key_slot() : key(), published(false) {}
+    };
+
+    // records the key of a newly assigned identifier
+    struct key_recorder
+    {
+        concurrent_interner *interner;
+        K key;
+        int operator()(int id)
+        {
+            interner->record(id, key);
+            return id;
+        }
     };
 
     private:
-        size_t _M;          // table size
-        size_t _N;          // number of elements present in table
-        node ** _buckets;   // buckets of values stored in nodes
+        parallel_hash_map<K,int,Lock> _map;
+        chunked_array<key_slot, KEY_CHUNK> _keys;
+        void record(int id, K key);
 
     public:
-
-        fixed_hash_map(size_t M = 64);
-        virtual ~fixed_hash_map();
-        bool contains(K key);
-        V& at(K key);
-        void insert(K key, V value);
-        int insert_and_get_count(K key, V value);
+        concurrent_interner(size_t M = 64, size_t L = 0);
+        virtual ~concurrent_interner();
+        int intern(K key);
+        void intern_many(const K* keys, size_t n, int* ids);
+        bool lookup(K key, int& id);
+        K key(int id);
         size_t size();
-        size_t bucket_count();
-        K* keys();
-        V* values();
-        void clear();
-        void print_buckets();
 };
 
 /**
- * @class parallel_hash_map ParallelHashMap.h "src/ParallelHashMap.h"
- * @brief A thread-safe hash map supporting insertion and lookup operations
- * @details The parallel_hash_map class is built ontop of the fixed_hash_map
- *      class, supporting insertion and lookup operations but not deletion as
- *      deletion is not needed in the OpenMOC application. This hash table uses
- *      chaining for collisions, as defined in fixed_hash_map. It offers lock
- *      free lookups in O(1) time on average and fine-grained locking for
- *      insertions in O(1) time on average as well. Resizing is conducted
- *      periodically during inserts, although the starting table size can be
- *      chosen to limit the number of resizing operations.
+ * @brief Constructor initializes an empty interner
+ * @param M initial number of buckets of the underlying map
+ * @param L number of lock stripes of the underlying map, zero to choose
+ *          automatically
  */
-template <class K, class V>
-class parallel_hash_map
+template <class K, class Lock>
+concurrent_interner<K,Lock>::concurrent_interner(size_t M, size_t L)
+    : _map(M, L)
 {
-    // padded pointer to hash table to avoid false sharing
-    struct paddedPointer
+}
+
+/**
+ * @brief Destructor frees the key chunks
+ */
+template <class K, class Lock>
+concurrent_interner<K,Lock>::~concurrent_interner()
+{
+}
+
+/**
+ * @brief Stores the key of a newly assigned identifier
+ * @param id identifier assigned to the key
+ * @param key key to be stored
+ */
+template <class K, class Lock>
+void concurrent_interner<K,Lock>::record(int id, K key)
+{
+    key_slot *slot = _keys.allocate(id);
+    slot->key = key;
+    slot->published.store(true, std::memory_order_release);
+}
+
+/**
+ * @brief Returns the identifier of a key, assigning a new one if needed
+ * @details Keys already present are found with a lock-free lookup. Otherwise
+ *          the key is inserted; if another thread inserted it in the
+ *          meantime, the identifier assigned by that thread is returned.
+ * @param key key to be interned
+ * @return identifier of the key
+ */
+template <class K, class Lock>
+int concurrent_interner<K,Lock>::intern(K key)
+{
+    int id;
+    if(_map.find(key, id))
+        return id;
+
+    key_recorder recorder = {this, key};
+    id = _map.insert_counted(key, recorder);
+    if(id < 0)
+        _map.find(key, id);
+    return id;
+}
+
+/**
+ * @brief Interns an array of keys
+ * @details With OpenMP the keys are interned in parallel, so the identifiers
+ *          given to new keys do not follow their order in the array.
+ * @param keys array of keys to be interned
+ * @param n number of keys
+ * @param ids array of length n set to the identifiers of the keys
+ */
+template <class K, class Lock>
+void concurrent_interner<K,Lock>::intern_many(const K* keys, size_t n,
+                                              int* ids)
+{
+    #pragma omp parallel for schedule(static)
+    for(size_t i=0; i<n; i++)
+        ids[i] = intern(keys[i]);
+}
+
+/**
+ * @brief Determines the identifier of a key without assigning one
+ * @param key key to be searched
+ * @param id set to the identifier of the key if it is present
+ * @return boolean value referring to whether the key has been interned
+ */
+template <class K, class Lock>
+bool concurrent_interner<K,Lock>::lookup(K key, int& id)
+{
+    return _map.find(key, id);
+}
+
+/**
+ * @brief Returns the key of a given identifier
+ * @details An exception is thrown if no key has been given the identifier.
+ *          Identifiers are claimed before their key is recorded, so the
+ *          slot of the identifier is checked rather than the number of
+ *          keys, which may already count an identifier whose key is still
+ *          being written by another thread.
+ * @param id identifier of the key
+ * @return key with the given identifier
+ */
+template <class K, class Lock>
+K concurrent_interner<K,Lock>::key(int id)
+{
+    key_slot *slot = NULL;
+    if(id >= 0)
+        slot = _keys.get(id);
+    if(slot == NULL || !slot->published.load(std::memory_order_acquire))
+        throw std::out_of_range("Identifier not present in interner");
+    return slot->key;
+}
+
+/**
+ * @brief Returns the number of keys interned
+ * @return number of keys interned
+ */
+template <class K, class Lock>
+size_t concurrent_interner<K,Lock>::size()
+{
+    return _map.size();
+}
+
+
+/**
+ * @brief Returns the number of slots of a small_parallel_hash_map
+ * @details The table holds at least twice the requested number of keys,
+ *          rounded up to a power of 2, so that it is never more than half
+ *          full and probe sequences stay short.
+ * @param N maximum number of keys to be stored
+ * @param M candidate number of slots
+ * @return number of slots
+ */
+constexpr size_t small_map_slots(size_t N, size_t M = 1)
+{
+    return (M >= 2*N) ? M : small_map_slots(N, 2*M);
+}
+
+/**
+ * @class small_parallel_hash_map ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief A thread-safe hash map of compile-time capacity for tiny key sets
+ * @details The small_parallel_hash_map class supports the same insertion and
+ *      lookup operations as parallel_hash_map for maps that only ever hold a
+ *      few hundred keys but receive a very large number of operations. The
+ *      table is a flat, cache-line aligned array of slots stored inline in
+ *      the object and resolved by linear probing. It is never resized, so no
+ *      announce array, locks or memory reclamation are needed. A slot is
+ *      claimed with a compare-and-swap on its state, filled, and published by
+ *      setting its state to full with release ordering, after which the key
+ *      and value are never modified by the map. Lookups are lock free and
+ *      only wait on slots which are being filled. The map holds at least N
+ *      keys; an exception is thrown if the table runs out of slots. Since
+ *      the object is over-aligned, it should be declared as a local or global
+ *      variable rather than allocated with new.
+ */
+template <class K, class V, size_t N>
+class small_parallel_hash_map
+{
+    // states of a slot
+    enum {EMPTY, BUSY, FULL};
+
+    struct slot
     {
-        volatile long pad_L1;
-        volatile long pad_L2;
-        volatile long pad_L3;
-        volatile long pad_L4;
-        volatile long pad_L5;
-        volatile long pad_L7;
-        volatile long pad_L8;
-        fixed_hash_map<K,V>* volatile value;
-        volatile long pad_R1;
-        volatile long pad_R2;
-        volatile long pad_R3;
-        volatile long pad_R4;
-        volatile long pad_R5;
-        volatile long pad_R6;
-        volatile long pad_R7;
-        volatile long pad_R8;
+        std::atomic<int> state;
+        K key;
+        V value;
     };
+
     private:
-        fixed_hash_map<K,V> *_table;
-        paddedPointer *_announce;
-        size_t _num_threads;
-        size_t _N;
-        #ifdef OPENMP
-        omp_lock_t * _locks;
-        size_t _num_locks;
-        #endif
-        void resize();
+        static constexpr size_t _M = small_map_slots(N);    // table size
+        alignas(64) slot _slots[_M];                        // flat table
+        alignas(64) std::atomic<size_t> _N;                 // number of keys
+        size_t home_slot(K key);
+        slot* search(K key);
 
     public:
-        parallel_hash_map(size_t M = 64, size_t L = 64);
-        virtual ~parallel_hash_map();
+        small_parallel_hash_map();
+        virtual ~small_parallel_hash_map();
         bool contains(K key);
         V& at(K key);
+        bool find(K key, V& value);
         void insert(K key, V value);
         int insert_and_get_count(K key, V value);
         size_t size();
         size_t bucket_count();
-        size_t num_locks();
         K* keys();
         V* values();
         void clear();
@@ -123,731 +3059,664 @@ class parallel_hash_map
 };
 
 /**
- * @brief Constructor initializes fixed-size table of buckets filled with empty
- *          linked lists.
- * @details The constructor initializes a fixed-size hash map with the size
- *          as an input parameter. If no size is given the default size (64)
- *          is used. Buckets are filled with empty linked lists presented as
- *          NULL pointers.
- * @param M size of fixed hash map
+ * @brief Constructor marks every slot of the table as empty.
  */
-template <class K, class V>
-fixed_hash_map<K,V>::fixed_hash_map(size_t M)
+template <class K, class V, size_t N>
+small_parallel_hash_map<K,V,N>::small_parallel_hash_map()
 {
-    // ensure M is a power of 2
-    if( M & (M-1) != 0 )
-    {
-        // if not, round up to nearest power of 2
-        M--;
-        for(size_t i = 1; i < 8 * sizeof(size_t); i*=2)
-            M |= M >> i;
-        M++;
-    }
+    for(size_t i=0; i<_M; i++)
+        _slots[i].state.store(EMPTY, std::memory_order_relaxed);
+    _N.store(0, std::memory_order_release);
+}
 
-    // allocate table
-    _M = M;
-    _N = 0;
-    _buckets = new node*[_M]();
+/**
+ * @brief Destructor, the table is stored inline so there is nothing to free.
+ */
+template <class K, class V, size_t N>
+small_parallel_hash_map<K,V,N>::~small_parallel_hash_map()
+{
 }
 
 /**
- * @brief Destructor deletes all nodes in the linked lists associated with each
- *          bucket in the fixed-size table and their pointers.
+ * @brief Returns the slot at which probing for a given key starts
+ * @details The standard library hash of integers is the identity, which
+ *          would place consecutive keys in consecutive slots and make linear
+ *          probes for absent keys walk across the whole cluster. The hash is
+ *          therefore scrambled with a multiplicative (Fibonacci) hash first.
+ * @param key key to be searched
+ * @return index of the first slot to be probed
  */
-template <class K, class V>
-fixed_hash_map<K,V>::~fixed_hash_map()
+template <class K, class V, size_t N>
+size_t small_parallel_hash_map<K,V,N>::home_slot(K key)
 {
-    // for each bucket, scan through linked list and delete all nodes
+    unsigned long long h = std::hash<K>()(key);
+    h *= 0x9E3779B97F4A7C15ULL;
+    return (size_t) (h >> 32) & (_M-1);
+}
+
+/**
+ * @brief Finds the slot holding a given key
+ * @details The table is probed linearly from the slot associated with the key
+ *          until either the key or an empty slot is found. Slots which are
+ *          being filled by another thread are waited on since they may hold
+ *          the searched key once published.
+ * @param key key to be searched
+ * @return pointer to the slot holding the key, NULL if it is not present
+ */
+template <class K, class V, size_t N>
+typename small_parallel_hash_map<K,V,N>::slot*
+small_parallel_hash_map<K,V,N>::search(K key)
+{
+    size_t key_hash = home_slot(key);
     for(size_t i=0; i<_M; i++)
     {
-        node *iter_node = _buckets[i];
-        while(iter_node != NULL)
+        slot *s = &_slots[(key_hash + i) & (_M-1)];
+        int state = s->state.load(std::memory_order_acquire);
+        size_t spins = 0;
+        while(state == BUSY)
         {
-            node *next_node = iter_node->next;
-            delete iter_node;
-            iter_node = next_node;
+            cpu_relax(spins);
+            state = s->state.load(std::memory_order_acquire);
         }
-    } 
-
-    // delete all buckets (now pointers to empty linked lists)
-    delete[] _buckets;
-} 
+        if(state == EMPTY)
+            return NULL;
+        if(s->key == key)
+            return s;
+    }
+    return NULL;
+}
 
 /**
- * @brief Determine whether the fixed-size table contains a given key
- * @details The linked list in the bucket associated with the key is searched
- *             to determine whether the key is present.
+ * @brief Determine whether the map contains a given key
  * @param key key to be searched
  * @return boolean value referring to whether the key is contained in the map
  */
-template <class K, class V>
-bool fixed_hash_map<K,V>::contains(K key)
+template <class K, class V, size_t N>
+bool small_parallel_hash_map<K,V,N>::contains(K key)
 {
-    // get hash into table assuming M is a power of 2, using fast modulus
-    size_t key_hash = std::hash<K>()(key) & (_M-1);
-
-    // search corresponding bucket for key
-    node *iter_node = _buckets[key_hash];
-    while(iter_node != NULL)
-    {
-        if(iter_node->key == key)
-            return true;
-        else
-            iter_node = iter_node->next;
-    }
-    return false;
+    return search(key) != NULL;
 }
 
 /**
- * @brief Determine the value associated with a given key in the fixed-size
- *          table.
- * @details The linked list in the bucket associated with the key is searched
- *          and once the key is found, the corresponding value is returned.
- *          An exception is thrown if the key is not present in the map.
+ * @brief Determine the value associated with a given key.
+ * @details An exception is thrown if the key is not present in the map.
  * @param key key whose corresponding value is desired
  * @return value associated with the given key
  */
-template <class K, class V>
-V& fixed_hash_map<K,V>::at(K key)
+template <class K, class V, size_t N>
+V& small_parallel_hash_map<K,V,N>::at(K key)
 {
-    // intialize value of type V
-    V val;
-
-    // get hash into table assuming M is a power of 2, using fast modulus
-    size_t key_hash = std::hash<K>()(key) & (_M-1);
-
-    // search bucket for key and return the corresponding value if found
-    node *iter_node = _buckets[key_hash];
-    while(iter_node != NULL)
-        if(iter_node->key == key)
-            return iter_node->value;
-        else
-            iter_node = iter_node->next;
-    
-    // after the bucket has been completely searched without finding the key,
-    // throw an exception
-    throw std::out_of_range("Key not present in map");
-    return val;
+    slot *s = search(key);
+    if(s == NULL)
+        throw std::out_of_range("Key not present in map");
+    return s->value;
 }
 
+/**
+ * @brief Copies the value associated with a given key.
+ * @details Values are never modified by the map once published, so the copy
+ *          is always consistent.
+ * @param key key whose corresponding value is desired
+ * @param value set to the value associated with the key if it is present
+ * @return boolean value referring to whether the key is contained in the map
+ */
+template <class K, class V, size_t N>
+bool small_parallel_hash_map<K,V,N>::find(K key, V& value)
+{
+    slot *s = search(key);
+    if(s == NULL)
+        return false;
+    value = s->value;
+    return true;
+}
 
 /**
- * @brief Inserts a key/value pair into the fixed-size table.
- * @details The specified key value pair is inserted into the fixed-size table.
- *          If the key already exists in the table, the pair is not inserted
- *          and the function returns.
+ * @brief Insert a given key/value pair into the map.
+ * @details If the key is already present the pair is not inserted.
  * @param key key of the key/value pair to be inserted
  * @param value value of the key/value pair to be inserted
  */
-template <class K, class V>
-void fixed_hash_map<K,V>::insert(K key, V value)
+template <class K, class V, size_t N>
+void small_parallel_hash_map<K,V,N>::insert(K key, V value)
 {
-    // get hash into table using fast modulus
-    size_t key_hash = std::hash<K>()(key) & (_M-1);
-
-    // check to see if key already exisits in map
-    if(contains(key))
-        return;
- 
-    // create new node
-    node *new_node = new node(key, value);
-
-    // find where to place element in linked list
-    node **iter_node = &_buckets[key_hash];
-    while(*iter_node != NULL)
-        iter_node = &(*iter_node)->next;
-    
-    // place element in linked list
-    *iter_node = new_node;
-    
-    // increment counter
-    #pragma omp atomic update
-    _N++;
-
-    return;
+    insert_and_get_count(key, value);
 }
 
 /**
- * @brief Inserts a key/value pair into the fixed-size table and returns the
- *          order number with which it was inserted.
- * @details The specified key value pair is inserted into the fixed-size table.
- *          If the key already exists in the table, the pair is not inserted
- *          and the function returns -1.
+ * @brief Insert a given key/value pair into the map and return the order
+ *          number.
+ * @details The table is probed linearly from the slot associated with the
+ *          key. Full slots are compared against the key and slots being
+ *          filled are waited on, so that a key is never inserted twice. The
+ *          first empty slot is claimed with a compare-and-swap, filled, and
+ *          then published. If another thread claims the slot first, the slot
+ *          is examined again. An exception is thrown if no slot is left.
  * @param key key of the key/value pair to be inserted
- * @param key value of the key/value pair to be inserted
- * @return order number in which key/value pair was inserted, -1 is returned if
- *          key was already present in map.
+ * @param value value of the key/value pair to be inserted
+ * @return order number in which the key/value pair was inserted, -1 if it
+ *          already exists
  */
-template <class K, class V>
-int fixed_hash_map<K,V>::insert_and_get_count(K key, V value)
+template <class K, class V, size_t N>
+int small_parallel_hash_map<K,V,N>::insert_and_get_count(K key, V value)
 {
-    // get hash into table using fast modulus
-    size_t key_hash = std::hash<K>()(key) & (_M-1);
-
-    // check to see if key already exisits in map
-    if(contains(key))
-        return -1;
- 
-    // create new node
-    node *new_node = new node(key, value);
-
-    // find where to place element in linked list
-    node **iter_node = &_buckets[key_hash];
-    while(*iter_node != NULL)
-        iter_node = &(*iter_node)->next;
-    
-    // place element in linked list
-    *iter_node = new_node;
-    
-    // increment counter and return number
-    size_t N;
-    #pragma omp atomic capture
-    N = _N++;
+    size_t key_hash = home_slot(key);
+    for(size_t i=0; i<_M; i++)
+    {
+        slot *s = &_slots[(key_hash + i) & (_M-1)];
+        int state = s->state.load(std::memory_order_acquire);
+        size_t spins = 0;
+        while(true)
+        {
+            // try to claim an empty slot
+            if(state == EMPTY)
+            {
+                if(s->state.compare_exchange_weak(state, BUSY,
+                        std::memory_order_acquire))
+                {
+                    s->key = key;
+                    s->value = value;
+                    size_t count = _N.fetch_add(1, std::memory_order_relaxed);
+                    s->state.store(FULL, std::memory_order_release);
+                    return (int) count;
+                }
+                continue;
+            }
+
+            // wait for the slot to be published
+            if(state == BUSY)
+            {
+                cpu_relax(spins);
+                state = s->state.load(std::memory_order_acquire);
+                continue;
+            }
+
+            // the slot is full, check whether it holds the key
+            if(s->key == key)
+                return -1;
+            break;
+        }
+    }
 
-    return (int) N;
+    throw std::length_error("Capacity of small_parallel_hash_map exceeded");
+    return -1;
 }
 
 /**
- * @brief Returns the number of key/value pairs in the fixed-size table
+ * @brief Returns the number of key/value pairs in the map
  * @return number of key/value pairs in the map
  */
-template <class K, class V>
-size_t fixed_hash_map<K,V>::size()
+template <class K, class V, size_t N>
+size_t small_parallel_hash_map<K,V,N>::size()
 {
-    return _N;
+    return _N.load(std::memory_order_relaxed);
 }
 
 /**
- * @brief Returns the number of buckets in the fixed-size table
- * @return number of buckets in the map
+ * @brief Returns the number of slots in the map
+ * @return number of slots in the map
  */
-template <class K, class V>
-size_t fixed_hash_map<K,V>::bucket_count()
+template <class K, class V, size_t N>
+size_t small_parallel_hash_map<K,V,N>::bucket_count()
 {
     return _M;
 }
 
 /**
- * @brief Returns an array of the keys in the fixed-size table
- * @details All buckets are scanned in order to form a list of all keys
+ * @brief Returns an array of the keys in the map
+ * @details All slots are scanned in order to form a list of all keys
  *          present in the table and then the list is returned
  * @return an array of keys in the map whose length is the number of key/value
  *          pairs in the table.
-*/
-template <class K, class V>
-K* fixed_hash_map<K,V>::keys()
-{
-    // allocate array of keys
-    K *key_list = new K[_N];
-
-    // fill array with keys
-    size_t ind = 0;
-    for(size_t i=0; i<_M; i++)
-    {
-        node *iter_node = _buckets[i];
-        while(iter_node != NULL)
-        {
-            key_list[ind] = iter_node->key;
-            iter_node = iter_node->next;
-            ind++;
-        }
-    }
+ */
+template <class K, class V, size_t N>
+K* small_parallel_hash_map<K,V,N>::keys()
+{
+    size_t num_keys = size();
+    K *key_list = new K[num_keys];
+    size_t ind = 0;
+    for(size_t i=0; i<_M && ind<num_keys; i++)
+        if(_slots[i].state.load(std::memory_order_acquire) == FULL)
+            key_list[ind++] = _slots[i].key;
     return key_list;
 }
 
 /**
- * @brief Returns an array of the values in the fixed-size table
- * @details All buckets are scanned in order to form a list of all values
+ * @brief Returns an array of the values in the map
+ * @details All slots are scanned in order to form a list of all values
  *          present in the table and then the list is returned
- * @return an array of values in the map whose length is the number of 
+ * @return an array of values in the map whose length is the number of
  *          key/value pairs in the table.
-*/
-template <class K, class V>
-V* fixed_hash_map<K,V>::values()
+ */
+template <class K, class V, size_t N>
+V* small_parallel_hash_map<K,V,N>::values()
 {
-    // allocate array of values
-    V *values = new V[_N];
-
-    // fill array with values
+    size_t num_values = size();
+    V *value_list = new V[num_values];
     size_t ind = 0;
-    for(size_t i=0; i<_M; i++)
-    {
-        node *iter_node = _buckets[i];
-        while(iter_node != NULL)
-        {
-            values[ind] = iter_node->value;
-            iter_node = iter_node->next;
-            ind++;
-        }
-    }
-    return values;
+    for(size_t i=0; i<_M && ind<num_values; i++)
+        if(_slots[i].state.load(std::memory_order_acquire) == FULL)
+            value_list[ind++] = _slots[i].value;
+    return value_list;
 }
 
 /**
- * @brief Clears all key/value pairs form the hash table.
+ * @brief Clears all key/value pairs from the map.
+ * @details This function must not be called concurrently with other
+ *          operations on the map.
  */
-template <class K, class V>
-void fixed_hash_map<K,V>::clear()
+template <class K, class V, size_t N>
+void small_parallel_hash_map<K,V,N>::clear()
 {
-    // for each bucket, scan through linked list and delete all nodes
-    for(size_t i=0; i<_M; i++)
-    {
-        node *iter_node = _buckets[i];
-        while(iter_node != NULL)
-        {
-            node *next_node = iter_node->next;
-            delete iter_node;
-            iter_node = next_node;
-        }
-    }
-
-    // reset each bucket to null
     for(size_t i=0; i<_M; i++)
-        _buckets[i] = NULL;
-
-    // reset the number of entries to zero
-    _N = 0;
-    
-    return;
+        _slots[i].state.store(EMPTY, std::memory_order_relaxed);
+    _N.store(0, std::memory_order_release);
 }
 
 /**
- * @brief Prints the contents of each bucket to the screen
- * @details All buckets are scanned and the contents of the buckets are
- *          printed, which are pointers to linked lists. If the pointer is NULL
- *          suggesting that the linked list is empty, NULL is printed to the
- *          screen.
+ * @brief Prints the contents of each slot to the screen
+ * @details All slots are scanned and the keys of the full slots are printed.
+ *          If a slot is empty, EMPTY is printed to the screen.
  */
-template <class K, class V>
-void fixed_hash_map<K,V>::print_buckets()
+template <class K, class V, size_t N>
+void small_parallel_hash_map<K,V,N>::print_buckets()
 {
     for(size_t i=0; i<_M; i++)
     {
-        if(_buckets[i] == NULL)
-            std::cout << i << " -> NULL" << std::endl;
+        if(_slots[i].state.load(std::memory_order_acquire) == FULL)
+            std::cout << i << " -> " << _slots[i].key << std::endl;
         else
-            std::cout << i << " -> " << _buckets[i] << std::endl;
+            std::cout << i << " -> EMPTY" << std::endl;
     }
 }
 
+#ifdef MPI
 /**
- * @brief Constructor for generates initial underlying table as a fixed-sized 
- *          hash map and intializes concurrency structures.
+ * @class distributed_hash_map ParallelHashMap.h "src/ParallelHashMap.h"
+ * @brief A hash map partitioned across the ranks of an MPI communicator
+ * @details Each rank owns a local parallel_hash_map holding the keys whose
+ *      hash maps to that rank. All operations are batched and collective:
+ *      every rank in the communicator must call them, possibly with an
+ *      empty batch. Keys of a batch are bucketed by owner and exchanged with
+ *      a single MPI_Alltoallv, applied to the local maps with OpenMP threads,
+ *      and the results are returned with a second MPI_Alltoallv. Keys and
+ *      values are sent as raw bytes and must therefore be trivially copyable.
+ *      MPI is only called from the calling thread, outside of OpenMP
+ *      parallel regions, so it must be initialized with MPI_Init_thread
+ *      providing at least MPI_THREAD_FUNNELED.
  */
 template <class K, class V>
-parallel_hash_map<K,V>::parallel_hash_map(size_t M, size_t L)
+class distributed_hash_map
 {
-    // allocate table
-    _table = new fixed_hash_map<K,V>(M);
-
-    // get number of threads and create concurrency structures
-    _num_threads = 1;
-    #ifdef OPENMP
-    _num_threads = omp_get_max_threads();
-    _num_locks = L;
-    _locks = new omp_lock_t[_num_locks];
-    for(size_t i=0; i<_num_locks; i++)
-        omp_init_lock(&_locks[i]);
-    #endif
+    private:
+        parallel_hash_map<K,V> *_local;
+        MPI_Comm _comm;
+        int _rank;
+        int _num_ranks;
+        long _N;
+        int owner(K key);
+        void partition(const K* keys, size_t n,
+                       std::vector<int> &send_counts,
+                       std::vector<int> &recv_counts,
+                       std::vector<size_t> &order);
+        template <class T>
+        void exchange(const T* send, const std::vector<int> &send_counts,
+                      T* recv, const std::vector<int> &recv_counts);
+        void insert_batch(const K* keys, const V* values, size_t n,
+                          long* counts);
 
-    _announce = new paddedPointer[_num_threads];
-}
+    public:
+        distributed_hash_map(MPI_Comm comm = MPI_COMM_WORLD, size_t M = 64,
+                             size_t L = 0);
+        virtual ~distributed_hash_map();
+        void contains(const K* keys, size_t n, bool* present);
+        void at(const K* keys, size_t n, V* values);
+        void insert(const K* keys, const V* values, size_t n);
+        void insert_and_get_count(const K* keys, const V* values, size_t n,
+                                  long* counts);
+        size_t size();
+        size_t local_size();
+        parallel_hash_map<K,V>* local_map();
+};
 
 /**
- * @brief Destructor frees memory associated with fixed-sized hash map and
- *          concurrency structures.
+ * @brief Constructor allocates the local portion of the distributed map.
+ * @param comm communicator across which the map is partitioned
+ * @param M initial size of the local table on each rank
+ * @param L number of locks of the local table on each rank, zero to size
+ *          automatically
  */
 template <class K, class V>
-parallel_hash_map<K,V>::~parallel_hash_map()
+distributed_hash_map<K,V>::distributed_hash_map(MPI_Comm comm, size_t M,
+        size_t L)
 {
-    delete _table;
-    #ifdef OPENMP  
-    delete[] _locks;
-    #endif
-    delete[] _announce;
+    _comm = comm;
+    MPI_Comm_rank(_comm, &_rank);
+    MPI_Comm_size(_comm, &_num_ranks);
+    _local = new parallel_hash_map<K,V>(M, L);
+    _N = 0;
 }
 
-
 /**
- * @brief Determine whether the parallel hash map contains a given key
- * @details First the thread accessing the table announces its presence and
- *          which table it is reading. Then the linked list in the bucket 
- *          associated with the key is searched without setting any locks
- *          to determine whether the key is present. When the thread has
- *          finished accessing the table, the announcement is reset to NULL.
- *          The announcement ensures that the data in the map is not freed
- *          during a resize until all threads have finished accessing the map.
- * @param key key to be searched
- * @return boolean value referring to whether the key is contained in the map
+ * @brief Destructor frees the local portion of the distributed map.
  */
 template <class K, class V>
-bool parallel_hash_map<K,V>::contains(K key)
+distributed_hash_map<K,V>::~distributed_hash_map()
 {
-    // get thread ID
-    size_t tid = 0;
-    #ifdef OPENMP
-    tid = omp_get_thread_num();
-    #endif
-
-    // get pointer to table, announce it will be searched, ensure consistency
-    fixed_hash_map<K,V> *table_ptr; 
-    do{
-        table_ptr = _table;
-        _announce[tid].value = table_ptr;
-    } while(table_ptr != _table);
-
-    // see if current table contains the thread
-    bool present = table_ptr->contains(key);
-    
-    // reset table announcement to not searching
-    _announce[tid].value = NULL;
-    
-    return present;
+    delete _local;
 }
 
 /**
- * @brief Determine the value associated with a given key.
- * @details This function follows the same algorithm as <contains> except that
- *          the value associated with the searched key is returned.
- *          First the thread accessing the table announces its presence and
- *          which table it is reading. Then the linked list in the bucket 
- *          associated with the key is searched without setting any locks
- *          to determine the associated value. An exception is thrown if the 
- *          key is not found. When the thread has finished accessing the table, 
- *          the announcement is reset to NULL. The announcement ensures that 
- *          the data in the map is not freed during a resize until all threads 
- *          have finished accessing the map.
- * @param key key to be searched
- * @return value associated with the key
+ * @brief Determines the rank owning a given key
+ * @details The key hash is scrambled before being reduced by the number of
+ *          ranks so that the keys owned by a rank still spread across all
+ *          buckets of its local table, which are indexed by the low bits of
+ *          the same hash.
+ * @param key key whose owner is desired
+ * @return rank owning the key
  */
 template <class K, class V>
-V& parallel_hash_map<K,V>::at(K key)
+int distributed_hash_map<K,V>::owner(K key)
 {
-    // get thread ID
-    size_t tid = 0;
-    #ifdef OPENMP
-    tid = omp_get_thread_num();
-    #endif
-
-    // get pointer to table, announce it will be searched
-    fixed_hash_map<K,V> *table_ptr; 
-    do{
-        table_ptr = _table;
-        _announce[tid].value = table_ptr;
-    } while(table_ptr != _table);
-    
-    // get value associated with the key in the underlying table
-    V& value = table_ptr->at(key);
-    
-    // reset table announcement to not searching
-    _announce[tid].value = NULL;
-    
-    return value;
+    unsigned long long h = std::hash<K>()(key);
+    h *= 0x9E3779B97F4A7C15ULL;
+    return (int) ((h >> 32) % (unsigned long long) _num_ranks);
 }
 
 /**
- * @brief Insert a given key/value pair into the parallel hash map.
- * @details First the underlying table is checked to determine if a resize
- *          should be conducted. Then, the table is checked to see if it
- *          already contains the key. If so, the key/value pair is not inserted
- *          and the function returns. Otherwise, the lock of the associated
- *          bucket is acquired and the key/value pair is added to the bucket.
- * @param key key of the key/value pair to be inserted
- * @param value value of the key/value pair to be inserted
+ * @brief Groups the keys of a batch by owning rank
+ * @details The number of keys destined to each rank is computed and
+ *          exchanged so that every rank knows how many keys it will receive
+ *          from every other rank. The returned order lists the batch indices
+ *          grouped by destination rank.
+ * @param keys keys of the batch
+ * @param n number of keys in the batch
+ * @param send_counts filled with the number of keys sent to each rank
+ * @param recv_counts filled with the number of keys received from each rank
+ * @param order filled with the batch indices grouped by destination rank
  */
 template <class K, class V>
-void parallel_hash_map<K,V>::insert(K key, V value)
+void distributed_hash_map<K,V>::partition(const K* keys, size_t n,
+        std::vector<int> &send_counts, std::vector<int> &recv_counts,
+        std::vector<size_t> &order)
 {
-    // check if resize needed
-    if(2*_table->size() > _table->bucket_count())
-        resize();
-
-    // check to see if key is already contained in the table
-    if(contains(key))
-        return;
-
-    // get lock hash
-    #ifdef OPENMP
-    size_t lock_hash = (std::hash<K>()(key) & (_table->bucket_count() - 1))
-        % _num_locks;
-
-    // acquire lock
-    omp_set_lock(&_locks[lock_hash]);
-    #endif
-
-    // insert value
-    _table->insert(key, value);
+    // count the keys destined to each rank
+    std::vector<int> owners(n);
+    send_counts.assign(_num_ranks, 0);
+    for(size_t i=0; i<n; i++)
+    {
+        owners[i] = owner(keys[i]);
+        send_counts[owners[i]]++;
+    }
 
-    // release lock
-    #ifdef OPENMP
-    omp_unset_lock(&_locks[lock_hash]);
-    #endif
-   
-    return;
+    // group batch indices by destination rank
+    std::vector<size_t> offsets(_num_ranks, 0);
+    for(int r=1; r<_num_ranks; r++)
+        offsets[r] = offsets[r-1] + send_counts[r-1];
+    order.resize(n);
+    for(size_t i=0; i<n; i++)
+        order[offsets[owners[i]]++] = i;
+
+    // tell every rank how many keys it will receive
+    recv_counts.assign(_num_ranks, 0);
+    MPI_Alltoall(&send_counts[0], 1, MPI_INT, &recv_counts[0], 1, MPI_INT,
+                 _comm);
 }
 
 /**
- * @brief Insert a given key/value pair into the parallel hash map and return
-            the order number.
- * @details First the underlying table is checked to determine if a resize
- *          should be conducted. Then, the table is checked to see if it
- *          already contains the key. If so, the key/value pair is not inserted
- *          and the function returns. Otherwise, the lock of the associated
- *          bucket is acquired and the key/value pair is added to the bucket.
- * @param key key of the key/value pair to be inserted
- * @param value value of the key/value pair to be inserted
- * @return order number in which the key/value pair was inserted, -1 if it
- *          already exists
+ * @brief Exchanges an array of elements grouped by rank between all ranks
+ * @param send elements to send, grouped by destination rank
+ * @param send_counts number of elements sent to each rank
+ * @param recv buffer receiving the elements, grouped by source rank
+ * @param recv_counts number of elements received from each rank
  */
 template <class K, class V>
-int parallel_hash_map<K,V>::insert_and_get_count(K key, V value)
+template <class T>
+void distributed_hash_map<K,V>::exchange(const T* send,
+        const std::vector<int> &send_counts, T* recv,
+        const std::vector<int> &recv_counts)
 {
-    // check if resize needed
-    if(2*_table->size() > _table->bucket_count())
-        resize();
-
-    // check to see if key is already contained in the table
-    if(contains(key))
-        return -1;
-
-    // get lock hash
-    #ifdef OPENMP
-    size_t lock_hash = (std::hash<K>()(key) & (_table->bucket_count() - 1))
-        % _num_locks;
-
-    // acquire lock
-    omp_set_lock(&_locks[lock_hash]);
-    #endif
-
-    // insert value
-    int N =_table->insert_and_get_count(key, value);
+    // convert element counts to byte counts and displacements
+    std::vector<int> send_bytes(_num_ranks), send_displs(_num_ranks, 0);
+    std::vector<int> recv_bytes(_num_ranks), recv_displs(_num_ranks, 0);
+    for(int r=0; r<_num_ranks; r++)
+    {
+        send_bytes[r] = send_counts[r] * sizeof(T);
+        recv_bytes[r] = recv_counts[r] * sizeof(T);
+        if(r > 0)
+        {
+            send_displs[r] = send_displs[r-1] + send_bytes[r-1];
+            recv_displs[r] = recv_displs[r-1] + recv_bytes[r-1];
+        }
+    }
 
-    // release lock
-    #ifdef OPENMP
-    omp_unset_lock(&_locks[lock_hash]);
-    #endif
-   
-    return N;
+    MPI_Alltoallv((void*) send, &send_bytes[0], &send_displs[0], MPI_BYTE,
+                  (void*) recv, &recv_bytes[0], &recv_displs[0], MPI_BYTE,
+                  _comm);
 }
+
 /**
- * @brief Resizes the underlying table to twice its current capacity.
- * @details In a thread-safe manner, this procedure resizes the underlying
- *      fixed_hash_map table to twice its current capacity using locks and the
- *      announce array. First, all locks are set in order to block inserts and
- *      prevent deadlock. A new table is allocated of twice the size and all
- *      key/value pairs from the old table, then the pointer is switched to the
- *      new table and locks are released. Finally the memory needs to be freed.
- *      To prevent threads currently reading the table from encountering
- *      segmentation faults, the resizing threads waits for the announce array
- *      to be free of references to the old table before freeing the memory.
+ * @brief Determine whether the distributed map contains each key of a batch
+ * @details This is a collective operation. Keys are sent to their owning
+ *          ranks, looked up in the local tables and the answers are sent
+ *          back to the requesting ranks.
+ * @param keys keys to be searched
+ * @param n number of keys to be searched
+ * @param present filled with whether each key is contained in the map
  */
 template <class K, class V>
-void parallel_hash_map<K,V>::resize()
+void distributed_hash_map<K,V>::contains(const K* keys, size_t n,
+        bool* present)
 {
-    // acquire all locks in order
-    #ifdef OPENMP
-    for(size_t i=0; i<_num_locks; i++)
-        omp_set_lock(&_locks[i]);
-    #endif 
-
-    // recheck if resize needed
-    if(2*_table->size() < _table->bucket_count())
-    {
-        // release locks
-        #ifdef OPENMP
-        for(size_t i=0; i<_num_locks; i++)
-            omp_unset_lock(&_locks[i]);
-        #endif 
-
-        return;
-    }
-
-    // allocate new hash map of double the size
-    fixed_hash_map<K,V> *new_map = 
-        new fixed_hash_map<K,V>(2*_table->bucket_count());
-
-    // get keys, values, and number of elements
-    K *key_list = _table->keys();
-    V *value_list = _table->values();
-
-    // insert key/value pairs into new hash map
-    for(size_t i=0; i<_table->size(); i++)
-        new_map->insert(key_list[i], value_list[i]);
-
-    // save pointer of old table
-    fixed_hash_map<K,V> *old_table = _table;
-
-    // reassign pointer
-    _table = new_map;
-
-    // release all locks
-    #ifdef OPENMP
-    for(size_t i=0; i<_num_locks; i++)
-        omp_unset_lock(&_locks[i]);
-    #endif
-
-    // delete key and value list
-    delete[] key_list;
-    delete[] value_list;
-
-    // wait for all threads to stop reading from the old table
-    for(size_t i=0; i<_num_threads; i++)
-        while(_announce[i].value == old_table) {};
-
-    // free memory associated with old table
-    delete old_table;
-
-    return;
+    // send keys to their owners
+    std::vector<int> send_counts, recv_counts;
+    std::vector<size_t> order;
+    partition(keys, n, send_counts, recv_counts, order);
+    std::vector<K> send_keys(n + 1);
+    for(size_t i=0; i<n; i++)
+        send_keys[i] = keys[order[i]];
+    size_t num_recv = 0;
+    for(int r=0; r<_num_ranks; r++)
+        num_recv += recv_counts[r];
+    std::vector<K> recv_keys(num_recv + 1);
+    exchange(&send_keys[0], send_counts, &recv_keys[0], recv_counts);
+
+    // search the local table
+    std::vector<char> recv_present(num_recv + 1);
+    #pragma omp parallel for
+    for(long i=0; i<(long) num_recv; i++)
+        recv_present[i] = _local->contains(recv_keys[i]);
+
+    // return answers to the requesting ranks
+    std::vector<char> send_present(n + 1);
+    exchange(&recv_present[0], recv_counts, &send_present[0], send_counts);
+    for(size_t i=0; i<n; i++)
+        present[order[i]] = send_present[i];
 }
 
 /**
- * @brief Returns the number of key/value pairs in the underlying table
- * @return number of key/value pairs in the map
+ * @brief Determine the values associated with each key of a batch
+ * @details This is a collective operation. Keys are sent to their owning
+ *          ranks, looked up in the local tables and the values are sent back
+ *          to the requesting ranks. An exception is thrown on a requesting
+ *          rank after the exchange completes if any of its keys is not
+ *          present in the map.
+ * @param keys keys whose corresponding values are desired
+ * @param n number of keys
+ * @param values filled with the value associated with each key
  */
 template <class K, class V>
-size_t parallel_hash_map<K,V>::size()
+void distributed_hash_map<K,V>::at(const K* keys, size_t n, V* values)
 {
-    return _table->size();
+    // send keys to their owners
+    std::vector<int> send_counts, recv_counts;
+    std::vector<size_t> order;
+    partition(keys, n, send_counts, recv_counts, order);
+    std::vector<K> send_keys(n + 1);
+    for(size_t i=0; i<n; i++)
+        send_keys[i] = keys[order[i]];
+    size_t num_recv = 0;
+    for(int r=0; r<_num_ranks; r++)
+        num_recv += recv_counts[r];
+    std::vector<K> recv_keys(num_recv + 1);
+    exchange(&send_keys[0], send_counts, &recv_keys[0], recv_counts);
+
+    // search the local table, flagging absent keys
+    std::vector<V> recv_values(num_recv + 1);
+    std::vector<char> recv_present(num_recv + 1);
+    #pragma omp parallel for
+    for(long i=0; i<(long) num_recv; i++)
+        recv_present[i] = _local->find(recv_keys[i], recv_values[i]);
+
+    // return values to the requesting ranks
+    std::vector<V> send_values(n + 1);
+    std::vector<char> send_present(n + 1);
+    exchange(&recv_values[0], recv_counts, &send_values[0], send_counts);
+    exchange(&recv_present[0], recv_counts, &send_present[0], send_counts);
+
+    bool missing = false;
+    for(size_t i=0; i<n; i++)
+    {
+        values[order[i]] = send_values[i];
+        if(!send_present[i])
+            missing = true;
+    }
+    if(missing)
+        throw std::out_of_range("Key not present in map");
 }
 
 /**
- * @brief Returns the number of buckets in the underlying table
- * @return number of buckets in the map
+ * @brief Inserts a batch of key/value pairs and optionally returns the global
+ *          order numbers with which they were inserted.
+ * @details Key/value pairs are sent to their owning ranks and inserted into
+ *          the local tables. Each rank then counts the keys it newly
+ *          inserted. Since the local order numbers of a batch form a
+ *          contiguous range, a prefix sum over the ranks turns them into
+ *          global order numbers which are dense and unique across all ranks.
+ * @param keys keys of the key/value pairs to be inserted
+ * @param values values of the key/value pairs to be inserted
+ * @param n number of key/value pairs
+ * @param counts if not NULL, filled with the global order number of each
+ *          pair, or -1 if the key was already present in the map
  */
 template <class K, class V>
-size_t parallel_hash_map<K,V>::bucket_count()
+void distributed_hash_map<K,V>::insert_batch(const K* keys, const V* values,
+        size_t n, long* counts)
 {
-    return _table->bucket_count();
+    // send key/value pairs to their owners
+    std::vector<int> send_counts, recv_counts;
+    std::vector<size_t> order;
+    partition(keys, n, send_counts, recv_counts, order);
+    std::vector<K> send_keys(n + 1);
+    std::vector<V> send_values(n + 1);
+    for(size_t i=0; i<n; i++)
+    {
+        send_keys[i] = keys[order[i]];
+        send_values[i] = values[order[i]];
+    }
+    size_t num_recv = 0;
+    for(int r=0; r<_num_ranks; r++)
+        num_recv += recv_counts[r];
+    std::vector<K> recv_keys(num_recv + 1);
+    std::vector<V> recv_values(num_recv + 1);
+    exchange(&send_keys[0], send_counts, &recv_keys[0], recv_counts);
+    exchange(&send_values[0], send_counts, &recv_values[0], recv_counts);
+
+    // insert into the local table
+    long local_before = (long) _local->size();
+    std::vector<long> recv_order(num_recv + 1);
+    #pragma omp parallel for
+    for(long i=0; i<(long) num_recv; i++)
+        recv_order[i] = _local->insert_and_get_count(recv_keys[i],
+                                                     recv_values[i]);
+
+    // find the global offset of the keys inserted by this rank
+    long num_new = (long) _local->size() - local_before;
+    long offset = 0;
+    long total_new = 0;
+    MPI_Exscan(&num_new, &offset, 1, MPI_LONG, MPI_SUM, _comm);
+    MPI_Allreduce(&num_new, &total_new, 1, MPI_LONG, MPI_SUM, _comm);
+    if(_rank == 0)
+        offset = 0;
+
+    // convert local order numbers to global order numbers
+    long base = _N + offset - local_before;
+    _N += total_new;
+    if(counts == NULL)
+        return;
+    for(size_t i=0; i<num_recv; i++)
+        if(recv_order[i] >= 0)
+            recv_order[i] += base;
+
+    // return order numbers to the requesting ranks
+    std::vector<long> send_order(n + 1);
+    exchange(&recv_order[0], recv_counts, &send_order[0], send_counts);
+    for(size_t i=0; i<n; i++)
+        counts[order[i]] = send_order[i];
 }
 
 /**
- * @brief Returns the number of locks in the parallel hash map
- * @return number of locks in the map
+ * @brief Inserts a batch of key/value pairs into the distributed map
+ * @details This is a collective operation. Pairs whose key is already
+ *          present in the map are not inserted.
+ * @param keys keys of the key/value pairs to be inserted
+ * @param values values of the key/value pairs to be inserted
+ * @param n number of key/value pairs
  */
 template <class K, class V>
-size_t parallel_hash_map<K,V>::num_locks()
+void distributed_hash_map<K,V>::insert(const K* keys, const V* values,
+        size_t n)
 {
-    return _num_locks;
+    insert_batch(keys, values, n, NULL);
 }
 
 /**
- * @brief Returns an array of the keys in the underlying table
- * @details All buckets are scanned in order to form a list of all keys
- *          present in the table and then the list is returned. Threads
- *          announce their presence to ensure table memory is not freed
- *          during access.
- * @return an array of keys in the map whose length is the number of key/value
- *          pairs in the table.
+ * @brief Inserts a batch of key/value pairs into the distributed map and
+ *          returns their global order numbers.
+ * @details This is a collective operation. The order numbers are consistent
+ *          across all ranks: every key present in the map has a unique order
+ *          number between zero and the global size of the map.
+ * @param keys keys of the key/value pairs to be inserted
+ * @param values values of the key/value pairs to be inserted
+ * @param n number of key/value pairs
+ * @param counts filled with the order number in which each pair was inserted,
+ *          -1 if its key was already present in the map
  */
 template <class K, class V>
-K* parallel_hash_map<K,V>::keys()
+void distributed_hash_map<K,V>::insert_and_get_count(const K* keys,
+        const V* values, size_t n, long* counts)
 {
-    // get thread ID
-    size_t tid = 0;
-    #ifdef OPENMP
-    tid = omp_get_thread_num();
-    #endif
-
-    // get pointer to table, announce it will be searched
-    fixed_hash_map<K,V> *table_ptr; 
-    do{
-        table_ptr = _table;
-        _announce[tid].value = table_ptr;
-    } while(table_ptr != _table);
-
-    // get key list
-    K* key_list = table_ptr->keys();
-
-    // reset table announcement to not searching
-    _announce[tid].value = NULL;
-
-    return key_list;
+    insert_batch(keys, values, n, counts);
 }
 
 /**
- * @brief Returns an array of the values in the underlying table
- * @details All buckets are scanned in order to form a list of all values
- *          present in the table and then the list is returned. Threads
- *          announce their presence to ensure table memory is not freed
- *          during access.
- * @return an array of values in the map whose length is the number of key/value
- *          pairs in the table.
+ * @brief Returns the number of key/value pairs across all ranks
+ * @return number of key/value pairs in the distributed map
  */
 template <class K, class V>
-V* parallel_hash_map<K,V>::values()
+size_t distributed_hash_map<K,V>::size()
 {
-    // get thread ID
-    size_t tid = 0;
-    #ifdef OPENMP
-    tid = omp_get_thread_num();
-    #endif
-
-    // get pointer to table, announce it will be searched
-    fixed_hash_map<K,V> *table_ptr; 
-    do{
-        table_ptr = _table;
-        _announce[tid].value = table_ptr;
-    } while(table_ptr != _table);
-
-    // get value list
-    V* value_list = table_ptr->values();
-    
-    // reset table announcement to not searching
-    _announce[tid].value = NULL;
-
-    return value_list;
+    return (size_t) _N;
 }
 
 /**
- * @brief Clears all key/value pairs form the hash table.
+ * @brief Returns the number of key/value pairs owned by this rank
+ * @return number of key/value pairs in the local table
  */
 template <class K, class V>
-void parallel_hash_map<K,V>::clear()
+size_t distributed_hash_map<K,V>::local_size()
 {
-    // acquire all locks in order
-    #ifdef OPENMP
-    for(size_t i=0; i<_num_locks; i++)
-        omp_set_lock(&_locks[i]);
-    #endif 
-
-    // clear underlying fixed table
-    _table->clear();
-
-    return;
+    return _local->size();
 }
 
 /**
- * @brief Prints the contents of each bucket to the screen
- * @details All buckets are scanned and the contents of the buckets are
- *          printed, which are pointers to linked lists. If the pointer is NULL
- *          suggesting that the linked list is empty, NULL is printed to the
- *          screen. Threads announce their presence to ensure table memory is
- *          not freed during access.
+ * @brief Returns the local table holding the keys owned by this rank
+ * @return pointer to the local parallel hash map
  */
 template <class K, class V>
-void parallel_hash_map<K,V>::print_buckets()
+parallel_hash_map<K,V>* distributed_hash_map<K,V>::local_map()
 {
-    // get thread ID
-    size_t tid = 0;
-    #ifdef OPENMP
-    tid = omp_get_thread_num();
-    #endif
-
-    // get pointer to table, announce it will be searched
-    fixed_hash_map<K,V> *table_ptr; 
-    do{
-        table_ptr = _table;
-        _announce[tid].value = table_ptr;
-    } while(table_ptr != _table);
-        
-    // print buckets
-    table_ptr->print_buckets();
-
-    // reset table announcement to not searching
-    _announce[tid].value = NULL;
-    
-    return;
+    return _local;
 }
-
+#endif
 
 #endif